@@ -0,0 +1,86 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+
+// Errores de API sin excepciones: código y, si aplica, el ID del objeto afectado o la operación
+// denegada. El texto del error solo se construye si alguien lo pide. Cada código conserva el mensaje
+// que lanzaba antes el recurso correspondiente.
+enum class ErrorCode {
+    BadRequest,
+    Unauthorized,
+    Forbidden,
+    AdminRequired,
+    UserAccessDenied,
+    NotFound,
+    UserNotFound,
+    // Siempre el último: número de códigos, para tablas indexadas por código
+    Count
+};
+
+struct ApiError {
+    ErrorCode code;
+    long objectId;
+    std::string operation;
+
+    explicit ApiError(ErrorCode code, long objectId = 0, std::string operation = {})
+        : code(code), objectId(objectId), operation(std::move(operation)) {}
+
+    std::string message() const {
+        switch (code) {
+            case ErrorCode::BadRequest: return "Bad request";
+            case ErrorCode::Unauthorized: return "Unauthorized";
+            case ErrorCode::Forbidden:
+                if (!operation.empty()) {
+                    return "Permission denied for operation: " + operation;
+                }
+                return objectId ? "Access denied to object with ID: " + std::to_string(objectId) : "Access denied";
+            case ErrorCode::AdminRequired: return "Administrator access required.";
+            case ErrorCode::UserAccessDenied: return "Access denied to user: " + std::to_string(objectId);
+            case ErrorCode::NotFound: return "Object not found with ID: " + std::to_string(objectId);
+            case ErrorCode::UserNotFound: return "User not found with ID: " + std::to_string(objectId);
+            case ErrorCode::Count: break;
+        }
+        return "Unknown error";
+    }
+};
+
+// Resultado al estilo de std::expected (C++23): contiene un valor o un ApiError
+template <typename T>
+class Expected {
+private:
+    std::variant<T, ApiError> storage;
+
+public:
+    Expected(T value) : storage(std::move(value)) {}
+    Expected(ApiError error) : storage(std::move(error)) {}
+
+    bool hasValue() const { return storage.index() == 0; }
+    explicit operator bool() const { return hasValue(); }
+
+    // Precondición: hasValue()
+    T& operator*() { return *std::get_if<0>(&storage); }
+    const T& operator*() const { return *std::get_if<0>(&storage); }
+    T* operator->() { return std::get_if<0>(&storage); }
+    const T* operator->() const { return std::get_if<0>(&storage); }
+
+    // Precondición: !hasValue()
+    const ApiError& error() const { return *std::get_if<1>(&storage); }
+};
+
+template <>
+class Expected<void> {
+private:
+    std::optional<ApiError> failure;
+
+public:
+    Expected() = default;
+    Expected(ApiError error) : failure(std::move(error)) {}
+
+    bool hasValue() const { return !failure; }
+    explicit operator bool() const { return hasValue(); }
+
+    const ApiError& error() const { return *failure; }
+};
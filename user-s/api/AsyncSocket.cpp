@@ -3,6 +3,22 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <unordered_set>
+#include <thread>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <charconv>
+#include <string_view>
 #include <nlohmann/json.hpp>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
@@ -13,33 +29,881 @@ namespace beast = boost::beast;
 namespace websocket = beast::websocket;
 namespace net = boost::asio;
 
-class AsyncSocket {
+// Tipo de mensaje saliente; decide la política cuando la cola de envío está llena
+enum class MessageKind {
+    Position,
+    Device,
+    Event,
+    Log
+};
+
+// Las posiciones JSON y los logs se pueden descartar (se conserva lo más reciente);
+// dispositivos y eventos no se descartan nunca
+inline bool isDroppable(MessageKind kind) {
+    return kind == MessageKind::Position || kind == MessageKind::Log;
+}
+
+// Fragmento JSON ya serializado, inmutable y compartido entre todas las conexiones que lo envían
+using Fragment = std::shared_ptr<const std::string>;
+
+inline Fragment makeFragment(const json& value) {
+    return std::make_shared<const std::string>(value.dump());
+}
+
+inline long positionDeviceId(const json& position) {
+    return position.contains("deviceId") ? position["deviceId"].get<long>() : position.value("id", 0L);
+}
+
+// Posición reducida a enteros escalados, base de la codificación binaria por deltas.
+// Campos: latitud y longitud (1e-7 grados), hora (ms), velocidad, rumbo y altitud (centésimas).
+struct PositionSample {
+    static constexpr std::size_t FIELD_COUNT = 6;
+
+    std::array<std::int64_t, FIELD_COUNT> fields{};
+
+    static std::int64_t scaled(const json& position, const char* key, double factor) {
+        auto it = position.find(key);
+        return it != position.end() && it->is_number() ? std::llround(it->get<double>() * factor) : 0;
+    }
+
+    static PositionSample fromJson(const json& position) {
+        PositionSample sample;
+        sample.fields = {
+            scaled(position, "latitude", 1e7),
+            scaled(position, "longitude", 1e7),
+            scaled(position, "fixTime", 1),
+            scaled(position, "speed", 100),
+            scaled(position, "course", 100),
+            scaled(position, "altitude", 100),
+        };
+        return sample;
+    }
+};
+
+// Subprotocolo binario opcional, negociado con Sec-WebSocket-Protocol. Cada trama de posiciones es:
+// tipo (1 byte), secuencia (varint, 0 si no tiene), número de posiciones (varint) y, por posición, el ID de dispositivo (varint), una
+// máscara de campos cambiados (1 byte) y el delta en zigzag-varint de cada campo cambiado respecto a
+// la última posición enviada a esa conexión para el mismo dispositivo.
+namespace BinaryProtocol {
+    constexpr char NAME[] = "traccar.binary.v1";
+    constexpr std::uint8_t POSITIONS = 1;
+
+    inline void writeVarint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    inline std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    inline void encodePosition(std::string& out, long deviceId, const PositionSample& sample, const PositionSample& previous) {
+        writeVarint(out, static_cast<std::uint64_t>(deviceId));
+        std::uint8_t mask = 0;
+        for (std::size_t i = 0; i < PositionSample::FIELD_COUNT; ++i) {
+            if (sample.fields[i] != previous.fields[i]) {
+                mask |= static_cast<std::uint8_t>(1u << i);
+            }
+        }
+        out.push_back(static_cast<char>(mask));
+        for (std::size_t i = 0; i < PositionSample::FIELD_COUNT; ++i) {
+            if (mask & (1u << i)) {
+                writeVarint(out, zigzag(sample.fields[i] - previous.fields[i]));
+            }
+        }
+    }
+}
+
+// Actualización difundida a un usuario con su número de secuencia
+struct StreamUpdate {
+    std::uint64_t seq;
+    MessageKind kind;
+    long deviceId;
+    Fragment fragment;
+    PositionSample sample;
+};
+
+// Secuencia monótona por usuario y anillo acotado con sus últimas actualizaciones. Un cliente que
+// reconecta con resumeFrom=<seq> recibe solo lo que se perdió, si todavía está en el anillo.
+class ReplayBuffer {
+private:
+    static constexpr std::uint64_t CAPACITY = 1024;
+
+    std::mutex mutex;
+    std::uint64_t nextSeq = 1;
+    std::vector<StreamUpdate> ring{CAPACITY};
+
+public:
+    // Asigna la secuencia y guarda la actualización bajo el bloqueo; la entrega se hace fuera, con
+    // una copia. Dos publicaciones concurrentes pueden llegar así en desorden a una conexión, que
+    // rellena el hueco desde el anillo (ver AsyncSocket::applyUpdate).
+    template <typename Deliver>
+    void publish(MessageKind kind, long deviceId, const Fragment& fragment, const PositionSample& sample,
+                 Deliver deliver) {
+        StreamUpdate update;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            StreamUpdate& slot = ring[nextSeq % CAPACITY];
+            slot = {nextSeq++, kind, deviceId, fragment, sample};
+            update = slot;
+        }
+        deliver(update);
+    }
+
+    // Copia en "missed" las actualizaciones posteriores a "seq" y devuelve la última secuencia
+    // en "latest". Devuelve false si el hueco ya no cabe en el anillo.
+    bool since(std::uint64_t seq, std::vector<StreamUpdate>& missed, std::uint64_t& latest) {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = nextSeq - 1;
+        std::uint64_t oldest = nextSeq > CAPACITY ? nextSeq - CAPACITY : 1;
+        if (seq > latest || seq + 1 < oldest) {
+            return false;
+        }
+        for (std::uint64_t current = seq + 1; current <= latest; ++current) {
+            missed.push_back(ring[current % CAPACITY]);
+        }
+        return true;
+    }
+};
+
+// Simulación del grafo de permisos: dispositivos visibles para cada usuario
+class PermissionsService {
+public:
+    // La simulación devuelve los mismos dispositivos para cualquier usuario
+    std::vector<long> getDeviceIds(long /* userId */) {
+        return { 1, 2, 3 };
+    }
+};
+
+// Cuenta una conexión activa en su io_context mientras el socket está vivo
+class ConnectionLease {
+private:
+    std::atomic<long>& connections;
+
+public:
+    explicit ConnectionLease(std::atomic<long>& connections) : connections(connections) {
+        connections++;
+    }
+
+    ~ConnectionLease() {
+        connections--;
+    }
+
+    ConnectionLease(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(const ConnectionLease&) = delete;
+};
+
+// Parámetros de permessage-deflate. Los bits de ventana y el nivel de memoria se reducen hasta
+// que el coste estimado de la conexión cabe en connectionBudgetBytes; si el total de todas las
+// conexiones supera totalBudgetBytes, las nuevas conexiones se atienden sin compresión.
+struct CompressionOptions {
+    bool enabled = true;
+    int windowBits = 12;
+    int memLevel = 4;
+    int compressionLevel = 6;
+    bool contextTakeover = true;
+    std::size_t connectionBudgetBytes = 64 * 1024;
+    std::size_t totalBudgetBytes = std::size_t(1) << 30;
+};
+
+// Memoria aproximada de un deflate y un inflate de zlib con estos parámetros
+inline std::size_t deflateMemory(int windowBits, int memLevel) {
+    return (std::size_t(1) << (windowBits + 2)) + (std::size_t(1) << (memLevel + 9))
+        + (std::size_t(1) << windowBits) + 7 * 1024;
+}
+
+// Presupuesto global de memoria de compresión compartido por todas las conexiones
+class CompressionBudget {
+private:
+    std::atomic<std::size_t> used{0};
+    std::size_t limit;
+
+public:
+    explicit CompressionBudget(std::size_t limit) : limit(limit) {}
+
+    bool reserve(std::size_t bytes) {
+        std::size_t current = used.load();
+        do {
+            if (current + bytes > limit) {
+                return false;
+            }
+        } while (!used.compare_exchange_weak(current, current + bytes));
+        return true;
+    }
+
+    void release(std::size_t bytes) {
+        used -= bytes;
+    }
+
+    std::size_t getUsed() const {
+        return used;
+    }
+};
+
+// Devuelve la memoria reservada al destruirse el socket
+class CompressionReservation {
+private:
+    CompressionBudget& budget;
+    std::size_t bytes;
+
+public:
+    CompressionReservation(CompressionBudget& budget, std::size_t bytes) : budget(budget), bytes(bytes) {}
+
+    ~CompressionReservation() {
+        budget.release(bytes);
+    }
+
+    CompressionReservation(const CompressionReservation&) = delete;
+    CompressionReservation& operator=(const CompressionReservation&) = delete;
+};
+
+// Histograma con cubos en potencias de dos: el cubo b cuenta valores en [2^b, 2^(b+1))
+class Histogram {
+private:
+    static constexpr std::size_t BUCKETS = 32;
+    std::array<std::atomic<unsigned long>, BUCKETS> counts{};
+
+public:
+    void record(unsigned long value) {
+        std::size_t bucket = 0;
+        while (value > 1 && bucket < BUCKETS - 1) {
+            value >>= 1;
+            bucket++;
+        }
+        counts[bucket]++;
+    }
+
+    unsigned long count(std::size_t bucket) const {
+        return counts[bucket];
+    }
+
+    static constexpr std::size_t size() {
+        return BUCKETS;
+    }
+};
+
+// Métricas del keepalive: RTT de ping/pong en ms y duración de las conexiones cerradas en segundos
+struct KeepaliveMetrics {
+    Histogram rttMillis;
+    Histogram connectionAgeSeconds;
+    std::atomic<unsigned long> idleClosed{0};
+    std::atomic<unsigned long> unresponsiveClosed{0};
+};
+
+struct KeepaliveOptions {
+    std::chrono::seconds pingInterval{30};
+    std::chrono::seconds pongTimeout{10};
+    std::chrono::seconds idleTimeout{120};
+};
+
+// Contadores de envío por conexión, para medir tramas y bytes por segundo
+struct SocketStats {
+    std::atomic<unsigned long> framesSent{0};
+    std::atomic<unsigned long> bytesSent{0};
+    std::atomic<unsigned long> updatesCoalesced{0};
+};
+
+class AsyncSocket : public std::enable_shared_from_this<AsyncSocket> {
 private:
+    // Tamaño de cola a partir del cual se descartan los mensajes más antiguos descartables
+    static constexpr std::size_t MAX_QUEUE_SIZE = 256;
+    // Límite absoluto: un cliente que no vacía ni siquiera los mensajes no descartables se cierra
+    static constexpr std::size_t HARD_QUEUE_LIMIT = 4 * MAX_QUEUE_SIZE;
+
+    // Trama compuesta por fragmentos compartidos y separadores estáticos, escrita con scatter/gather
+    struct OutboundMessage {
+        MessageKind kind;
+        std::vector<Fragment> fragments;
+        std::vector<net::const_buffer> buffers;
+        bool binary = false;
+
+        explicit OutboundMessage(MessageKind kind) : kind(kind) {}
+
+        // Las tramas binarias llevan deltas contra lastSentSamples: descartar una dejaría al cliente
+        // con otra base y todas las siguientes se decodificarían mal, así que nunca se descartan
+        bool droppable() const {
+            return !binary && isDroppable(kind);
+        }
+
+        void appendLiteral(std::string_view text) {
+            buffers.emplace_back(text.data(), text.size());
+        }
+
+        void appendFragment(Fragment fragment) {
+            buffers.emplace_back(fragment->data(), fragment->size());
+            fragments.push_back(std::move(fragment));
+        }
+
+        // Añade "key":[f1,f2,...] tomando cada fragmento de los elementos con "fragmentOf"
+        template <typename Items, typename FragmentOf>
+        void appendSection(std::string_view key, const Items& items, FragmentOf fragmentOf) {
+            appendLiteral(buffers.empty() ? "{" : ",");
+            appendLiteral(key);
+            bool first = true;
+            for (const auto& item : items) {
+                if (!first) {
+                    appendLiteral(",");
+                }
+                appendFragment(fragmentOf(item));
+                first = false;
+            }
+            appendLiteral("]");
+        }
+    };
+
     websocket::stream<beast::tcp_stream> ws;
     long userId;
     bool includeLogs;
+    std::chrono::milliseconds coalesceWindow;
+    SocketStats stats;
 
-    void sendData(const json& data) {
-        try {
-            ws.text(true);
-            ws.write(net::buffer(data.dump()));
-        } catch (const std::exception& e) {
-            std::cerr << "Error sending data: " << e.what() << std::endl;
+    // Solo se accede desde el ejecutor (strand) del stream
+    std::deque<OutboundMessage> outbound;
+    bool writing = false;
+    // Se escribe en el strand pero el gestor de keepalive la consulta desde su propio hilo
+    std::atomic<bool> closed{false};
+
+    // Actualizaciones acumuladas durante la ventana: última posición y último estado por dispositivo
+    net::steady_timer flushTimer;
+    bool flushScheduled = false;
+    std::unordered_map<long, Fragment> pendingPositions;
+    std::unordered_map<long, Fragment> pendingDevices;
+    std::vector<Fragment> pendingEvents;
+    std::vector<Fragment> pendingLogs;
+
+    // Con el subprotocolo binario las posiciones se acumulan como muestras y se codifican
+    // por deltas contra la última enviada a esta conexión
+    bool binaryPositions = false;
+    std::unordered_map<long, PositionSample> pendingSamples;
+    std::unordered_map<long, PositionSample> lastSentSamples;
+
+    std::function<void(AsyncSocket&)> closeListener;
+    std::shared_ptr<ConnectionLease> lease;
+    std::unique_ptr<CompressionReservation> compression;
+    CompressionBudget* compressionBudget = nullptr;
+    std::size_t compressionCost = 0;
+    websocket::permessage_deflate deflateOffer;
+
+    // Reanudación: secuencia pedida por el cliente, última secuencia encolada y la mayor incluida
+    // en la próxima trama binaria y en la próxima trama JSON
+    std::shared_ptr<ReplayBuffer> replayBuffer;
+    std::optional<std::uint64_t> resumeFrom;
+    std::uint64_t lastQueuedSeq = 0;
+    std::uint64_t pendingBinarySeq = 0;
+    std::uint64_t pendingJsonSeq = 0;
+    bool streamStarted = false;
+
+    // Estado de keepalive, solo en el strand
+    beast::flat_buffer readBuffer;
+    std::chrono::steady_clock::time_point connectedAt = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastActivity = connectedAt;
+    std::optional<std::chrono::steady_clock::time_point> pingSentAt;
+    std::shared_ptr<KeepaliveMetrics> keepaliveMetrics;
+    bool closeNotified = false;
+
+    // Serializa en el hilo que llama y encola en el strand; nunca bloquea al emisor
+    void sendData(const json& data, MessageKind kind) {
+        OutboundMessage message{kind};
+        message.appendFragment(makeFragment(data));
+        net::post(ws.get_executor(), [self = shared_from_this(), message = std::move(message)]() mutable {
+            self->enqueue(std::move(message));
+        });
+    }
+
+    void enqueue(OutboundMessage message) {
+        if (closed) {
+            return;
+        }
+        if (outbound.size() >= MAX_QUEUE_SIZE && message.droppable()) {
+            // El primer mensaje puede estar escribiéndose y no se toca
+            auto it = std::find_if(outbound.begin() + (writing ? 1 : 0), outbound.end(),
+                    [](const OutboundMessage& queued) { return queued.droppable(); });
+            if (it == outbound.end()) {
+                return;
+            }
+            outbound.erase(it);
+        }
+        if (outbound.size() >= HARD_QUEUE_LIMIT) {
+            std::cerr << "Send queue overflow, closing socket for user: " << userId << std::endl;
+            closeSocket();
+            return;
+        }
+        outbound.push_back(std::move(message));
+        if (!writing) {
+            doWrite();
+        }
+    }
+
+    // Acumula una actualización en el strand y programa el envío al final de la ventana
+    template <typename Merge>
+    void coalesce(Merge merge) {
+        net::post(ws.get_executor(), [self = shared_from_this(), merge = std::move(merge)]() mutable {
+            merge();
+            self->scheduleFlush();
+        });
+    }
+
+    void scheduleFlush() {
+        if (coalesceWindow.count() == 0) {
+            flushPending();
+        } else if (!flushScheduled) {
+            flushScheduled = true;
+            flushTimer.expires_after(coalesceWindow);
+            flushTimer.async_wait([self = shared_from_this()](beast::error_code ec) {
+                self->flushScheduled = false;
+                if (!ec) {
+                    self->flushPending();
+                }
+            });
+        }
+    }
+
+    void mergePosition(long deviceId, Fragment position, const PositionSample& sample) {
+        bool inserted = binaryPositions
+                ? pendingSamples.insert_or_assign(deviceId, sample).second
+                : pendingPositions.insert_or_assign(deviceId, std::move(position)).second;
+        if (!inserted) {
+            stats.updatesCoalesced++;
+        }
+    }
+
+    void mergeDevice(long deviceId, Fragment device) {
+        if (!pendingDevices.insert_or_assign(deviceId, std::move(device)).second) {
+            stats.updatesCoalesced++;
+        }
+    }
+
+    // Aplica una actualización secuenciada en el strand; descarta las ya encoladas, que pueden
+    // llegar repetidas tras una reanudación, y las anteriores a la conexión, que cubre la
+    // instantánea o la reanudación inicial
+    // Ante un hueco (una publicación anterior aún en camino) se copian del anillo todas las que
+    // faltan y se aplican en orden; la que llegue tarde se descarta por su secuencia
+    void applyUpdate(const StreamUpdate& update) {
+        if (!streamStarted || update.seq <= lastQueuedSeq) {
+            return;
+        }
+        if (update.seq > lastQueuedSeq + 1 && replayBuffer) {
+            std::vector<StreamUpdate> missed;
+            std::uint64_t latest = 0;
+            if (replayBuffer->since(lastQueuedSeq, missed, latest)) {
+                for (const auto& pending : missed) {
+                    applySequenced(pending);
+                }
+                return;
+            }
+        }
+        applySequenced(update);
+    }
+
+    void applySequenced(const StreamUpdate& update) {
+        lastQueuedSeq = update.seq;
+        (binaryPositions && update.kind == MessageKind::Position ? pendingBinarySeq : pendingJsonSeq) = update.seq;
+        switch (update.kind) {
+            case MessageKind::Position:
+                mergePosition(update.deviceId, update.fragment, update.sample);
+                break;
+            case MessageKind::Device:
+                mergeDevice(update.deviceId, update.fragment);
+                break;
+            default:
+                pendingEvents.push_back(update.fragment);
+                break;
+        }
+    }
+
+    // Busca el parámetro resumeFrom en la query; el valor debe ser un número completo
+    static std::optional<std::uint64_t> parseResumeFrom(std::string_view target) {
+        auto query = target.find('?');
+        if (query == std::string_view::npos) {
+            return std::nullopt;
+        }
+        target.remove_prefix(query + 1);
+        while (!target.empty()) {
+            auto ampersand = target.find('&');
+            auto parameter = target.substr(0, ampersand);
+            target = ampersand == std::string_view::npos ? std::string_view() : target.substr(ampersand + 1);
+            auto equals = parameter.find('=');
+            if (equals == std::string_view::npos || parameter.substr(0, equals) != "resumeFrom") {
+                continue;
+            }
+            auto value = parameter.substr(equals + 1);
+            std::uint64_t seq = 0;
+            auto end = value.data() + value.size();
+            auto result = std::from_chars(value.data(), end, seq);
+            if (value.empty() || result.ec != std::errc() || result.ptr != end) {
+                return std::nullopt;
+            }
+            return seq;
+        }
+        return std::nullopt;
+    }
+
+    // Envía todo lo acumulado como una sola trama {"positions":[...],"devices":[...],"events":[...]},
+    // y de la trama binaria de posiciones si se negoció ese subprotocolo. Cada trama lleva
+    // la mayor secuencia que contiene y se encolan en orden creciente de secuencia.
+    void flushPending() {
+        std::optional<OutboundMessage> binaryMessage;
+        if (!pendingSamples.empty()) {
+            std::string frame;
+            frame.push_back(static_cast<char>(BinaryProtocol::POSITIONS));
+            BinaryProtocol::writeVarint(frame, pendingBinarySeq);
+            BinaryProtocol::writeVarint(frame, pendingSamples.size());
+            for (const auto& [deviceId, sample] : pendingSamples) {
+                auto& previous = lastSentSamples[deviceId];
+                BinaryProtocol::encodePosition(frame, deviceId, sample, previous);
+                previous = sample;
+            }
+            pendingSamples.clear();
+
+            binaryMessage.emplace(MessageKind::Position);
+            binaryMessage->binary = true;
+            binaryMessage->appendFragment(std::make_shared<const std::string>(std::move(frame)));
+        }
+
+        OutboundMessage message{MessageKind::Log};
+        auto mapped = [](const auto& entry) { return entry.second; };
+        auto direct = [](const Fragment& fragment) { return fragment; };
+        if (!pendingPositions.empty()) {
+            message.appendSection("\"positions\":[", pendingPositions, mapped);
+            message.kind = MessageKind::Position;
+        }
+        if (!pendingDevices.empty()) {
+            message.appendSection("\"devices\":[", pendingDevices, mapped);
+            message.kind = MessageKind::Device;
+        }
+        if (!pendingEvents.empty()) {
+            message.appendSection("\"events\":[", pendingEvents, direct);
+            message.kind = MessageKind::Event;
+        }
+        if (!pendingLogs.empty()) {
+            message.appendSection("\"logs\":[", pendingLogs, direct);
+        }
+        pendingPositions.clear();
+        pendingDevices.clear();
+        pendingEvents.clear();
+        pendingLogs.clear();
+
+        bool jsonFirst = binaryMessage && pendingJsonSeq < pendingBinarySeq;
+        if (binaryMessage && !jsonFirst) {
+            enqueue(std::move(*binaryMessage));
+        }
+        if (!message.buffers.empty()) {
+            if (pendingJsonSeq > 0) {
+                message.appendFragment(std::make_shared<const std::string>(",\"seq\":" + std::to_string(pendingJsonSeq)));
+            }
+            message.appendLiteral("}");
+            enqueue(std::move(message));
+        }
+        if (binaryMessage && jsonFirst) {
+            enqueue(std::move(*binaryMessage));
+        }
+        pendingBinarySeq = 0;
+        pendingJsonSeq = 0;
+    }
+
+    void doRead() {
+        ws.async_read(readBuffer, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) {
+                self->onWebSocketClose();
+                return;
+            }
+            self->lastActivity = std::chrono::steady_clock::now();
+            self->onWebSocketText(beast::buffers_to_string(self->readBuffer.data()));
+            self->readBuffer.consume(self->readBuffer.size());
+            self->doRead();
+        });
+    }
+
+    void onControlFrame(websocket::frame_type kind) {
+        auto now = std::chrono::steady_clock::now();
+        lastActivity = now;
+        if (kind == websocket::frame_type::pong && pingSentAt) {
+            if (keepaliveMetrics) {
+                keepaliveMetrics->rttMillis.record(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(now - *pingSentAt).count());
+            }
+            pingSentAt.reset();
+        }
+    }
+
+    // Descarta lo pendiente salvo el mensaje que async_write aún está leyendo, que se libera en onWrite
+    void discardQueued() {
+        outbound.erase(outbound.begin() + (writing && !outbound.empty() ? 1 : 0), outbound.end());
+    }
+
+    void closeSocket() {
+        closed = true;
+        discardQueued();
+        beast::error_code ignored;
+        beast::get_lowest_layer(ws).socket().close(ignored);
+    }
+
+    void doWrite() {
+        writing = true;
+        ws.text(!outbound.front().binary);
+        ws.async_write(outbound.front().buffers,
+                [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                    self->onWrite(ec);
+                });
+    }
+
+    void onWrite(beast::error_code ec) {
+        writing = false;
+        if (ec) {
+            std::cerr << "Error sending data: " << ec.message() << std::endl;
+            closed = true;
+        }
+        if (closed || outbound.empty()) {
+            outbound.clear();
+            return;
+        }
+        stats.framesSent++;
+        stats.bytesSent += net::buffer_size(outbound.front().buffers);
+        outbound.pop_front();
+        if (!outbound.empty()) {
+            doWrite();
         }
     }
 
 public:
-    AsyncSocket(net::ip::tcp::socket&& socket, long userId)
-        : ws(std::move(socket)), userId(userId), includeLogs(false) {}
+    // coalesceWindow en cero envía cada actualización en su propia trama
+    AsyncSocket(net::ip::tcp::socket&& socket, long userId,
+                std::chrono::milliseconds coalesceWindow = std::chrono::milliseconds(200))
+        : ws(std::move(socket)), userId(userId), includeLogs(false), coalesceWindow(coalesceWindow),
+          flushTimer(ws.get_executor()) {}
+
+    long getUserId() const {
+        return userId;
+    }
+
+    const SocketStats& getStats() const {
+        return stats;
+    }
 
+    void setCloseListener(std::function<void(AsyncSocket&)> listener) {
+        closeListener = std::move(listener);
+    }
+
+    // Elige el subprotocolo entre los ofrecidos por el cliente en Sec-WebSocket-Protocol;
+    // debe llamarse antes de aceptar la conexión. Sin coincidencia se mantiene JSON.
+    void negotiateProtocol(std::string_view offered) {
+        while (!offered.empty()) {
+            auto comma = offered.find(',');
+            auto token = offered.substr(0, comma);
+            offered = comma == std::string_view::npos ? std::string_view() : offered.substr(comma + 1);
+            while (!token.empty() && token.front() == ' ') {
+                token.remove_prefix(1);
+            }
+            while (!token.empty() && token.back() == ' ') {
+                token.remove_suffix(1);
+            }
+            if (token == BinaryProtocol::NAME) {
+                binaryPositions = true;
+                ws.set_option(websocket::stream_base::decorator([](websocket::response_type& response) {
+                    response.set(beast::http::field::sec_websocket_protocol, BinaryProtocol::NAME);
+                }));
+                return;
+            }
+        }
+    }
+
+    // Lee la petición de upgrade, negocia el subprotocolo y la compresión, completa el handshake y empieza a leer
+    void start() {
+        auto request = std::make_shared<beast::http::request<beast::http::string_body>>();
+        beast::http::async_read(beast::get_lowest_layer(ws), readBuffer, *request,
+                [self = shared_from_this(), request](beast::error_code ec, std::size_t) {
+                    if (ec) {
+                        std::cerr << "Upgrade request error: " << ec.message() << std::endl;
+                        self->onWebSocketClose();
+                        return;
+                    }
+                    auto offered = (*request)[beast::http::field::sec_websocket_protocol];
+                    self->negotiateProtocol(std::string_view(offered.data(), offered.size()));
+                    auto extensions = (*request)[beast::http::field::sec_websocket_extensions];
+                    self->negotiateCompression(std::string_view(extensions.data(), extensions.size()));
+                    auto target = request->target();
+                    self->resumeFrom = parseResumeFrom(std::string_view(target.data(), target.size()));
+                    self->ws.control_callback([weak = std::weak_ptr<AsyncSocket>(self)](
+                            websocket::frame_type kind, beast::string_view) {
+                        if (auto socket = weak.lock()) {
+                            socket->onControlFrame(kind);
+                        }
+                    });
+                    self->ws.async_accept(*request, [self, request](beast::error_code ec) {
+                        if (ec) {
+                            std::cerr << "Handshake error: " << ec.message() << std::endl;
+                            self->onWebSocketClose();
+                            return;
+                        }
+                        self->readBuffer.consume(self->readBuffer.size());
+                        self->onWebSocketConnect();
+                        self->doRead();
+                    });
+                });
+    }
+
+    // Revisión periódica del gestor de keepalive: cierra la conexión si no respondió al último
+    // ping o lleva demasiado tiempo inactiva; si no, envía un nuevo ping
+    void checkKeepalive(const KeepaliveOptions& options) {
+        net::post(ws.get_executor(), [self = shared_from_this(), options] {
+            if (self->closed) {
+                return;
+            }
+            auto& metrics = self->keepaliveMetrics;
+            auto now = std::chrono::steady_clock::now();
+            if (self->pingSentAt && now - *self->pingSentAt > options.pongTimeout) {
+                if (metrics) {
+                    metrics->unresponsiveClosed++;
+                }
+                self->closeSocket();
+            } else if (now - self->lastActivity > options.idleTimeout) {
+                if (metrics) {
+                    metrics->idleClosed++;
+                }
+                self->closeSocket();
+            } else if (!self->pingSentAt && self->ws.is_open()) {
+                self->pingSentAt = now;
+                self->ws.async_ping({}, [self](beast::error_code ec) {
+                    if (ec) {
+                        self->closeSocket();
+                    }
+                });
+            }
+        });
+    }
+
+    // Revisión de plazo tras un ping: solo cierra si el pong lleva más de pongTimeout de retraso
+    void checkPongDeadline(std::chrono::seconds pongTimeout) {
+        net::post(ws.get_executor(), [self = shared_from_this(), pongTimeout] {
+            if (self->closed || !self->pingSentAt
+                    || std::chrono::steady_clock::now() - *self->pingSentAt <= pongTimeout) {
+                return;
+            }
+            if (self->keepaliveMetrics) {
+                self->keepaliveMetrics->unresponsiveClosed++;
+            }
+            self->closeSocket();
+        });
+    }
+
+    bool isClosed() const {
+        return closed;
+    }
+
+    // Debe llamarse antes de start() para que las conexiones que cierran pronto también cuenten
+    void setKeepaliveMetrics(std::shared_ptr<KeepaliveMetrics> metrics) {
+        keepaliveMetrics = std::move(metrics);
+    }
+
+    void setReplayBuffer(std::shared_ptr<ReplayBuffer> buffer) {
+        replayBuffer = std::move(buffer);
+    }
+
+    void setConnectionLease(std::shared_ptr<ConnectionLease> connectionLease) {
+        lease = std::move(connectionLease);
+    }
+
+    // Prepara permessage-deflate para el handshake; debe llamarse antes de start(). La memoria se
+    // reserva en negotiateCompression solo si el cliente pide la extensión. Devuelve false si la
+    // configuración no cabe en connectionBudgetBytes y la conexión queda sin compresión.
+    bool enableCompression(const CompressionOptions& options, CompressionBudget& budget) {
+        if (!options.enabled) {
+            return false;
+        }
+        int windowBits = options.windowBits;
+        int memLevel = options.memLevel;
+        // zlib exige al menos 9 bits de ventana
+        while (deflateMemory(windowBits, memLevel) > options.connectionBudgetBytes && (windowBits > 9 || memLevel > 1)) {
+            if (windowBits > 9) {
+                windowBits--;
+            } else {
+                memLevel--;
+            }
+        }
+        std::size_t cost = deflateMemory(windowBits, memLevel);
+        if (cost > options.connectionBudgetBytes) {
+            return false;
+        }
+        compressionBudget = &budget;
+        compressionCost = cost;
+
+        deflateOffer.server_enable = true;
+        deflateOffer.server_max_window_bits = windowBits;
+        deflateOffer.client_max_window_bits = windowBits;
+        deflateOffer.server_no_context_takeover = !options.contextTakeover;
+        deflateOffer.client_no_context_takeover = !options.contextTakeover;
+        deflateOffer.compLevel = options.compressionLevel;
+        deflateOffer.memLevel = memLevel;
+        return true;
+    }
+
+    // Activa permessage-deflate si el cliente lo ofrece en Sec-WebSocket-Extensions y queda
+    // presupuesto; si no, el handshake se completa sin compresión y no se reserva memoria
+    void negotiateCompression(std::string_view offered) {
+        if (!compressionBudget) {
+            return;
+        }
+        bool requested = false;
+        while (!offered.empty() && !requested) {
+            auto comma = offered.find(',');
+            auto token = offered.substr(0, comma);
+            offered = comma == std::string_view::npos ? std::string_view() : offered.substr(comma + 1);
+            token = token.substr(0, token.find(';'));
+            while (!token.empty() && token.front() == ' ') {
+                token.remove_prefix(1);
+            }
+            while (!token.empty() && token.back() == ' ') {
+                token.remove_suffix(1);
+            }
+            requested = token == "permessage-deflate";
+        }
+        if (!requested || !compressionBudget->reserve(compressionCost)) {
+            return;
+        }
+        compression = std::make_unique<CompressionReservation>(*compressionBudget, compressionCost);
+        ws.set_option(deflateOffer);
+    }
+
+    // Se ejecuta en el strand. Si el cliente pidió reanudar y el hueco sigue en el anillo, solo se
+    // envían las actualizaciones perdidas; si no, una instantánea con la secuencia actual.
     void onWebSocketConnect() {
+        streamStarted = true;
+        std::vector<StreamUpdate> missed;
+        std::uint64_t latest = 0;
+        if (replayBuffer && resumeFrom && replayBuffer->since(*resumeFrom, missed, latest)) {
+            lastQueuedSeq = *resumeFrom;
+            for (const auto& update : missed) {
+                applySequenced(update);
+            }
+            lastQueuedSeq = latest;
+            flushPending();
+            return;
+        }
+        lastQueuedSeq = latest;
+
         json initialData;
         initialData["positions"] = { { "id", 1 }, { "latitude", 40.7128 }, { "longitude", -74.0060 } };
-        sendData(initialData);
+        initialData["seq"] = latest;
+        sendData(initialData, MessageKind::Position);
     }
 
     void onWebSocketClose() {
+        if (closeNotified) {
+            return;
+        }
+        closeNotified = true;
+        closed = true;
         std::cout << "WebSocket closed for user: " << userId << std::endl;
+        if (keepaliveMetrics) {
+            keepaliveMetrics->connectionAgeSeconds.record(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::steady_clock::now() - connectedAt).count());
+        }
+        if (closeListener) {
+            closeListener(*this);
+        }
     }
 
     void onWebSocketText(const std::string& message) {
@@ -54,43 +918,499 @@ public:
     }
 
     void onUpdateDevice(const json& device) {
-        sendData({ { "devices", { device } } });
+        onUpdateDevice(device.value("id", 0L), makeFragment(device));
+    }
+
+    void onUpdateDevice(long deviceId, Fragment device) {
+        coalesce([this, deviceId, device = std::move(device)]() mutable {
+            mergeDevice(deviceId, std::move(device));
+        });
     }
 
     void onUpdatePosition(const json& position) {
-        sendData({ { "positions", { position } } });
+        onUpdatePosition(positionDeviceId(position), makeFragment(position), PositionSample::fromJson(position));
+    }
+
+    void onUpdatePosition(long deviceId, Fragment position, const PositionSample& sample) {
+        coalesce([this, deviceId, position = std::move(position), sample]() mutable {
+            mergePosition(deviceId, std::move(position), sample);
+        });
+    }
+
+    // Actualización secuenciada del flujo del usuario
+    void onStreamUpdate(const StreamUpdate& update) {
+        coalesce([this, update] {
+            applyUpdate(update);
+        });
     }
 
     void onUpdateEvent(const json& event) {
-        sendData({ { "events", { event } } });
+        onUpdateEvent(makeFragment(event));
+    }
+
+    void onUpdateEvent(Fragment event) {
+        coalesce([this, event = std::move(event)]() mutable {
+            pendingEvents.push_back(std::move(event));
+        });
     }
 
     void onUpdateLog(const json& log) {
         if (includeLogs) {
-            sendData({ { "logs", { log } } });
+            coalesce([this, log = makeFragment(log)]() mutable {
+                pendingLogs.push_back(std::move(log));
+            });
         }
     }
 };
 
-int main() {
-    try {
-        net::io_context ioc;
-        net::ip::tcp::endpoint endpoint(net::ip::tcp::v4(), 8080);
-        net::ip::tcp::acceptor acceptor(ioc, endpoint);
+// Índice de suscripciones: para cada dispositivo, los usuarios con permiso sobre él y, para cada
+// usuario, sus conexiones abiertas y su flujo de reanudación. Se deriva del grafo de permisos al
+// conectar el primer socket de un usuario y se mantiene con los cambios de permisos, de modo que
+// despachar una actualización solo recorre los suscriptores reales del dispositivo. Un usuario
+// sin conexiones se conserva durante "retention" para que su flujo siga acumulando lo que se
+// pierde mientras reconecta.
+class SubscriptionIndex {
+public:
+    struct UserSubscribers {
+        long userId;
+        std::shared_ptr<ReplayBuffer> replayBuffer;
+        std::vector<std::shared_ptr<AsyncSocket>> sockets;
+    };
+
+private:
+    struct Subscriber {
+        AsyncSocket* key;
+        std::weak_ptr<AsyncSocket> socket;
+    };
+
+    struct UserEntry {
+        std::unordered_set<long> devices;
+        std::vector<Subscriber> sockets;
+        std::shared_ptr<ReplayBuffer> replayBuffer = std::make_shared<ReplayBuffer>();
+        std::optional<std::chrono::steady_clock::time_point> retainUntil;
+    };
+
+    struct Retained {
+        long userId;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    PermissionsService& permissionsService;
+    std::chrono::seconds retention;
+    std::shared_mutex mutex;
+    std::unordered_map<long, std::vector<long>> deviceUsers;
+    std::unordered_map<long, UserEntry> users;
+    std::deque<Retained> retained;
+
+    void removeDeviceUser(long deviceId, long userId) {
+        auto it = deviceUsers.find(deviceId);
+        if (it != deviceUsers.end()) {
+            it->second.erase(std::remove(it->second.begin(), it->second.end(), userId), it->second.end());
+            if (it->second.empty()) {
+                deviceUsers.erase(it);
+            }
+        }
+    }
+
+    // Elimina los usuarios sin conexiones cuya retención ha caducado
+    void purgeExpired(std::chrono::steady_clock::time_point now) {
+        while (!retained.empty() && retained.front().expires <= now) {
+            long userId = retained.front().userId;
+            retained.pop_front();
+            auto it = users.find(userId);
+            if (it != users.end() && it->second.sockets.empty()
+                    && it->second.retainUntil && *it->second.retainUntil <= now) {
+                for (long deviceId : it->second.devices) {
+                    removeDeviceUser(deviceId, userId);
+                }
+                users.erase(it);
+            }
+        }
+    }
+
+public:
+    // Llamada periódica (p. ej. desde la rueda de KeepaliveManager) para liberar usuarios retenidos
+    // aunque no haya conexiones ni cierres; sin nada caducado solo toma el bloqueo compartido
+    void purgeExpired() {
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if (retained.empty() || retained.front().expires > now) {
+                return;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        purgeExpired(now);
+    }
+
+    explicit SubscriptionIndex(PermissionsService& permissionsService,
+                               std::chrono::seconds retention = std::chrono::seconds(300))
+        : permissionsService(permissionsService), retention(retention) {}
+
+    void onConnect(const std::shared_ptr<AsyncSocket>& socket) {
+        long userId = socket->getUserId();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        purgeExpired(std::chrono::steady_clock::now());
+        auto [it, inserted] = users.try_emplace(userId);
+        UserEntry& user = it->second;
+        if (inserted) {
+            for (long deviceId : permissionsService.getDeviceIds(userId)) {
+                if (user.devices.insert(deviceId).second) {
+                    deviceUsers[deviceId].push_back(userId);
+                }
+            }
+        }
+        user.retainUntil.reset();
+        user.sockets.push_back({socket.get(), socket});
+        socket->setReplayBuffer(user.replayBuffer);
+    }
+
+    void onClose(AsyncSocket& socket) {
+        long userId = socket.getUserId();
+        auto now = std::chrono::steady_clock::now();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = users.find(userId);
+        if (it != users.end()) {
+            auto& sockets = it->second.sockets;
+            sockets.erase(std::remove_if(sockets.begin(), sockets.end(),
+                    [&socket](const Subscriber& subscriber) { return subscriber.key == &socket; }), sockets.end());
+            if (sockets.empty()) {
+                it->second.retainUntil = now + retention;
+                retained.push_back({userId, now + retention});
+            }
+        }
+        purgeExpired(now);
+    }
+
+    // Llamar cuando se concede al usuario acceso a un dispositivo
+    void onPermissionAdded(long userId, long deviceId) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = users.find(userId);
+        if (it != users.end() && it->second.devices.insert(deviceId).second) {
+            deviceUsers[deviceId].push_back(userId);
+        }
+    }
+
+    // Llamar cuando se retira al usuario el acceso a un dispositivo
+    void onPermissionRemoved(long userId, long deviceId) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = users.find(userId);
+        if (it != users.end() && it->second.devices.erase(deviceId) > 0) {
+            removeDeviceUser(deviceId, userId);
+        }
+    }
+
+    // Usuarios interesados en el dispositivo con sus conexiones; coste proporcional a sus suscriptores
+    std::vector<UserSubscribers> getSubscribers(long deviceId) {
+        std::vector<UserSubscribers> result;
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = deviceUsers.find(deviceId);
+        if (it != deviceUsers.end()) {
+            result.reserve(it->second.size());
+            for (long userId : it->second) {
+                const UserEntry& user = users.at(userId);
+                UserSubscribers subscribers{userId, user.replayBuffer, {}};
+                for (const auto& subscriber : user.sockets) {
+                    if (auto socket = subscriber.socket.lock()) {
+                        subscribers.sockets.push_back(std::move(socket));
+                    }
+                }
+                result.push_back(std::move(subscribers));
+            }
+        }
+        return result;
+    }
+};
+
+// Difunde cada actualización serializándola una sola vez; todas las conexiones suscritas
+// al dispositivo encolan el mismo buffer inmutable. Cada usuario recibe la actualización con
+// su propia secuencia, que queda en su anillo de reanudación aunque no tenga conexiones abiertas.
+class BroadcastHub {
+private:
+    SubscriptionIndex subscriptions;
+
+    void publish(long deviceId, MessageKind kind, const Fragment& fragment, const PositionSample& sample) {
+        for (const auto& user : subscriptions.getSubscribers(deviceId)) {
+            user.replayBuffer->publish(kind, deviceId, fragment, sample, [&user](const StreamUpdate& update) {
+                for (const auto& socket : user.sockets) {
+                    socket->onStreamUpdate(update);
+                }
+            });
+        }
+    }
+
+public:
+    explicit BroadcastHub(PermissionsService& permissionsService) : subscriptions(permissionsService) {}
+
+    void subscribe(const std::shared_ptr<AsyncSocket>& socket) {
+        subscriptions.onConnect(socket);
+        socket->setCloseListener([this](AsyncSocket& closed) {
+            subscriptions.onClose(closed);
+        });
+    }
+
+    SubscriptionIndex& getSubscriptions() {
+        return subscriptions;
+    }
+
+    void broadcastDevice(const json& device) {
+        publish(device.value("id", 0L), MessageKind::Device, makeFragment(device), PositionSample{});
+    }
+
+    void broadcastPosition(const json& position) {
+        publish(positionDeviceId(position), MessageKind::Position, makeFragment(position),
+                PositionSample::fromJson(position));
+    }
+
+    void broadcastEvent(const json& event) {
+        publish(event.value("deviceId", 0L), MessageKind::Event, makeFragment(event), PositionSample{});
+    }
+};
+
+// Gestor de keepalive con una rueda de temporizadores: un único temporizador avanza una ranura por
+// tick y solo revisa las conexiones de esa ranura, que vuelven a la misma ranura para la siguiente
+// vuelta. Cada conexión se revisa una vez por pingInterval sin un steady_timer propio. Cada revisión
+// deja además una entrada de un solo uso pongTimeout más adelante, para cerrar a tiempo las
+// conexiones que no responden al ping en vez de esperar a la vuelta siguiente.
+class KeepaliveManager {
+private:
+    static constexpr std::size_t WHEEL_SIZE = 64;
+
+    struct Entry {
+        std::weak_ptr<AsyncSocket> socket;
+        bool pongDeadline = false;
+    };
+
+    KeepaliveOptions options;
+    std::shared_ptr<KeepaliveMetrics> metrics = std::make_shared<KeepaliveMetrics>();
+    net::steady_timer timer;
+    std::chrono::steady_clock::duration tick;
+    // Ranuras entre una revisión y su plazo de pong; el tick extra cubre el retraso hasta que el
+    // socket envía el ping. Si no cabe en una vuelta, el plazo lo vigila la revisión siguiente.
+    std::size_t pongSlots;
 
-        std::cout << "WebSocket server running on port 8080..." << std::endl;
+    std::mutex mutex;
+    std::array<std::vector<Entry>, WHEEL_SIZE> wheel;
+    std::size_t cursor = 0;
+    std::vector<std::function<void()>> tickListeners;
 
-        acceptor.async_accept([
-            &ioc
-        ](boost::system::error_code ec, net::ip::tcp::socket socket) {
+    void schedule() {
+        timer.expires_after(tick);
+        timer.async_wait([this](beast::error_code ec) {
             if (!ec) {
-                std::make_shared<AsyncSocket>(std::move(socket), 12345)->onWebSocketConnect();
-            } else {
-                std::cerr << "Accept error: " << ec.message() << std::endl;
+                onTick();
+                schedule();
+            }
+        });
+    }
+
+    void onTick() {
+        for (const auto& listener : tickListeners) {
+            listener();
+        }
+
+        std::vector<Entry> slot;
+        std::size_t index;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            index = cursor;
+            slot.swap(wheel[index]);
+            cursor = (cursor + 1) % WHEEL_SIZE;
+        }
+
+        std::vector<Entry> keep;
+        std::vector<Entry> deadlines;
+        keep.reserve(slot.size());
+        for (auto& entry : slot) {
+            auto socket = entry.socket.lock();
+            if (!socket || socket->isClosed()) {
+                continue;
+            }
+            if (entry.pongDeadline) {
+                socket->checkPongDeadline(options.pongTimeout);
+                continue;
+            }
+            socket->checkKeepalive(options);
+            if (pongSlots < WHEEL_SIZE) {
+                deadlines.push_back({entry.socket, true});
+            }
+            keep.push_back(std::move(entry));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& target = wheel[index];
+        target.insert(target.end(), std::make_move_iterator(keep.begin()), std::make_move_iterator(keep.end()));
+        auto& deadlineSlot = wheel[(index + pongSlots) % WHEEL_SIZE];
+        deadlineSlot.insert(deadlineSlot.end(),
+                std::make_move_iterator(deadlines.begin()), std::make_move_iterator(deadlines.end()));
+    }
+
+public:
+    KeepaliveManager(net::io_context& ioc, const KeepaliveOptions& options)
+        : options(options), timer(ioc), tick(std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.pingInterval) / WHEEL_SIZE),
+          pongSlots(static_cast<std::size_t>((options.pongTimeout + tick - std::chrono::steady_clock::duration(1)) / tick) + 1) {
+        schedule();
+    }
+
+    // Tareas de mantenimiento que se ejecutan en cada tick de la rueda. Debe llamarse antes de
+    // arrancar el io_context.
+    void addTickListener(std::function<void()> listener) {
+        tickListeners.push_back(std::move(listener));
+    }
+
+    // Debe llamarse antes de start() del socket
+    void add(const std::shared_ptr<AsyncSocket>& socket) {
+        socket->setKeepaliveMetrics(metrics);
+        std::lock_guard<std::mutex> lock(mutex);
+        // La ranura anterior al cursor es la última en revisarse: primera revisión tras una vuelta
+        wheel[(cursor + WHEEL_SIZE - 1) % WHEEL_SIZE].push_back({socket});
+    }
+
+    const KeepaliveMetrics& getMetrics() const {
+        return *metrics;
+    }
+};
+
+// Un io_context por núcleo, cada uno atendido por su propio hilo
+class IoContextPool {
+private:
+    struct Context {
+        net::io_context ioc{1};
+        net::executor_work_guard<net::io_context::executor_type> work{ioc.get_executor()};
+        std::atomic<long> connections{0};
+    };
+
+    std::vector<std::unique_ptr<Context>> contexts;
+
+public:
+    explicit IoContextPool(std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            contexts.push_back(std::make_unique<Context>());
+        }
+    }
+
+    std::size_t size() const {
+        return contexts.size();
+    }
+
+    net::io_context& get(std::size_t index) {
+        return contexts[index]->ioc;
+    }
+
+    // Contexto con menos conexiones activas
+    std::size_t leastLoaded() const {
+        std::size_t best = 0;
+        for (std::size_t i = 1; i < contexts.size(); ++i) {
+            if (contexts[i]->connections < contexts[best]->connections) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    std::shared_ptr<ConnectionLease> lease(std::size_t index) {
+        return std::make_shared<ConnectionLease>(contexts[index]->connections);
+    }
+
+    // Bloquea hasta que se llame a stop()
+    void run() {
+        std::vector<std::thread> threads;
+        for (auto& context : contexts) {
+            threads.emplace_back([&ioc = context->ioc] { ioc.run(); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void stop() {
+        for (auto& context : contexts) {
+            context->work.reset();
+            context->ioc.stop();
+        }
+    }
+};
+
+// Aceptador de un io_context del pool. Todos los aceptadores escuchan el mismo puerto con
+// SO_REUSEPORT y el kernel reparte las conexiones; si otro contexto está menos cargado,
+// el socket aceptado se traspasa a ese contexto.
+class Listener : public std::enable_shared_from_this<Listener> {
+public:
+    using AcceptHandler = std::function<void(net::ip::tcp::socket, std::shared_ptr<ConnectionLease>)>;
+
+private:
+    IoContextPool& pool;
+    std::size_t index;
+    net::ip::tcp::acceptor acceptor;
+    AcceptHandler handler;
+
+    void doAccept() {
+        acceptor.async_accept(net::make_strand(pool.get(index)),
+                [self = shared_from_this()](boost::system::error_code ec, net::ip::tcp::socket socket) {
+                    self->onAccept(ec, std::move(socket));
+                });
+    }
+
+    void onAccept(boost::system::error_code ec, net::ip::tcp::socket socket) {
+        if (ec) {
+            std::cerr << "Accept error: " << ec.message() << std::endl;
+        } else {
+            std::size_t target = pool.leastLoaded();
+            if (target != index) {
+                auto protocol = socket.local_endpoint().protocol();
+                socket = net::ip::tcp::socket(net::make_strand(pool.get(target)), protocol, socket.release());
             }
+            handler(std::move(socket), pool.lease(target));
+        }
+        doAccept();
+    }
+
+public:
+    Listener(IoContextPool& pool, std::size_t index, const net::ip::tcp::endpoint& endpoint, AcceptHandler handler)
+        : pool(pool), index(index), acceptor(pool.get(index)), handler(std::move(handler)) {
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(net::socket_base::reuse_address(true));
+#ifdef SO_REUSEPORT
+        acceptor.set_option(net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+        acceptor.bind(endpoint);
+        acceptor.listen(net::socket_base::max_listen_connections);
+    }
+
+    void run() {
+        doAccept();
+    }
+};
+
+int main() {
+    try {
+        net::ip::tcp::endpoint endpoint(net::ip::tcp::v4(), 8080);
+        IoContextPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        PermissionsService permissionsService;
+        BroadcastHub hub(permissionsService);
+        CompressionOptions compressionOptions;
+        CompressionBudget compressionBudget(compressionOptions.totalBudgetBytes);
+        KeepaliveManager keepalive(pool.get(0), KeepaliveOptions{});
+        keepalive.addTickListener([&hub] {
+            hub.getSubscriptions().purgeExpired();
         });
 
-        ioc.run();
+        auto onAccept = [&](net::ip::tcp::socket socket, std::shared_ptr<ConnectionLease> lease) {
+            // Cada conexión recibe su propio strand para serializar sus escrituras
+            auto asyncSocket = std::make_shared<AsyncSocket>(std::move(socket), 12345);
+            asyncSocket->setConnectionLease(std::move(lease));
+            asyncSocket->enableCompression(compressionOptions, compressionBudget);
+            hub.subscribe(asyncSocket);
+            keepalive.add(asyncSocket);
+            asyncSocket->start();
+        };
+
+        for (std::size_t i = 0; i < pool.size(); ++i) {
+            std::make_shared<Listener>(pool, i, endpoint, onAccept)->run();
+        }
+
+        std::cout << "WebSocket server running on port 8080 with " << pool.size() << " threads..." << std::endl;
+        pool.run();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
@@ -3,6 +3,15 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <list>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/websocket.hpp>
@@ -13,11 +22,18 @@ namespace beast = boost::beast;
 namespace websocket = beast::websocket;
 namespace net = boost::asio;
 
+// Resultado de la autenticación; expiration es la caducidad propia del token, si la tiene
+struct LoginResult {
+    long userId;
+    std::optional<std::chrono::system_clock::time_point> expiration;
+};
+
 class LoginService {
 public:
-    std::optional<long> login(const std::string& token) {
+    std::optional<LoginResult> login(const std::string& token) {
         if (token == "valid_token") {
-            return 12345; // Simulación del ID de usuario autenticado
+            // Simulación del ID de usuario autenticado con un token válido una hora
+            return LoginResult{12345, std::chrono::system_clock::now() + std::chrono::hours(1)};
         }
         return std::nullopt;
     }
@@ -37,49 +53,250 @@ public:
     }
 };
 
-class AsyncSocketServlet {
+// Verificador de tokens con caché. Los aciertos se resuelven sin salir del hilo de E/S; los fallos
+// se verifican en el pool de trabajadores y las verificaciones simultáneas del mismo token
+// (típicas de una avalancha de reconexiones) comparten una sola llamada a LoginService.
+// La caché guarda como mucho maxEntries tokens y expulsa el menos usado recientemente. Un token
+// válido se guarda como mucho hasta su propia caducidad, y invalidate() lo retira al revocarlo.
+class TokenVerifier {
+public:
+    using Callback = std::function<void(std::optional<long>)>;
+
 private:
-    LoginService loginService;
+    struct CachedResult {
+        std::optional<long> userId;
+        std::chrono::steady_clock::time_point expires;
+        std::list<std::string>::iterator position;
+    };
 
-public:
-    void handleConnection(net::ip::tcp::socket&& socket, const std::map<std::string, std::string>& params) {
+    LoginService& loginService;
+    net::thread_pool& workers;
+    std::chrono::seconds ttl;
+    std::chrono::seconds negativeTtl;
+    std::size_t maxEntries;
+
+    // Incluso los aciertos reordenan la lista LRU, así que todo acceso es exclusivo
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, CachedResult> cache;
+    std::list<std::string> recency;
+    std::chrono::steady_clock::time_point lastSweep;
+    // Cambia con cada invalidación: una verificación que empezó antes no guarda su resultado
+    std::uint64_t generation = 0;
+
+    void erase(std::unordered_map<std::string, CachedResult>::iterator it) {
+        recency.erase(it->second.position);
+        cache.erase(it);
+    }
+
+    // Llamar con cacheMutex tomado. Como mucho una vez por negativeTtl recorre la caché entera
+    // quitando lo caducado; después expulsa por el final de la lista LRU hasta dejar sitio.
+    void store(const std::string& token, std::optional<long> userId, std::chrono::steady_clock::time_point now,
+               std::chrono::steady_clock::time_point expires) {
+        auto existing = cache.find(token);
+        if (existing != cache.end()) {
+            erase(existing);
+        }
+        if (now - lastSweep >= negativeTtl) {
+            lastSweep = now;
+            for (auto it = cache.begin(); it != cache.end();) {
+                auto current = it++;
+                if (current->second.expires <= now) {
+                    erase(current);
+                }
+            }
+        }
+        while (!recency.empty() && cache.size() >= maxEntries) {
+            erase(cache.find(recency.back()));
+        }
+        recency.push_front(token);
+        cache.emplace(token, CachedResult{userId, expires, recency.begin()});
+    }
+
+    std::mutex pendingMutex;
+    std::unordered_map<std::string, std::vector<Callback>> pending;
+
+    void verifyOnWorker(const std::string& token) {
+        std::uint64_t startGeneration;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            startGeneration = generation;
+        }
+        std::optional<LoginResult> result;
+        try {
+            result = loginService.login(token);
+        } catch (const std::exception& e) {
+            std::cerr << "Token verification error: " << e.what() << std::endl;
+        }
+
+        auto now = std::chrono::steady_clock::now();
         std::optional<long> userId;
+        auto expires = now + negativeTtl;
+        if (result) {
+            userId = result->userId;
+            expires = now + ttl;
+            if (result->expiration) {
+                // La caducidad del token es de reloj de pared; se traslada al reloj monótono de la caché
+                auto remaining = *result->expiration - std::chrono::system_clock::now();
+                expires = std::min(expires, now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(remaining));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (generation == startGeneration && expires > now) {
+                store(token, userId, now, expires);
+            }
+        }
 
-        auto tokenIt = params.find("token");
-        if (tokenIt != params.end()) {
-            userId = loginService.login(tokenIt->second);
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            auto it = pending.find(token);
+            callbacks = std::move(it->second);
+            pending.erase(it);
+        }
+        for (auto& callback : callbacks) {
+            callback(userId);
         }
+    }
+
+public:
+    TokenVerifier(LoginService& loginService, net::thread_pool& workers,
+                  std::chrono::seconds ttl = std::chrono::seconds(300),
+                  std::chrono::seconds negativeTtl = std::chrono::seconds(5),
+                  std::size_t maxEntries = 100000)
+        : loginService(loginService), workers(workers), ttl(ttl), negativeTtl(negativeTtl),
+          maxEntries(std::max<std::size_t>(1, maxEntries)), lastSweep(std::chrono::steady_clock::now()) {}
+
+    // Resultado en caché, si existe y no ha caducado
+    std::optional<std::optional<long>> lookup(const std::string& token) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(token);
+        if (it == cache.end()) {
+            return std::nullopt;
+        }
+        if (it->second.expires <= std::chrono::steady_clock::now()) {
+            erase(it);
+            return std::nullopt;
+        }
+        recency.splice(recency.begin(), recency, it->second.position);
+        return it->second.userId;
+    }
 
+    // Retira el token de la caché (p. ej. al revocarlo); la siguiente conexión con él vuelve a
+    // pasar por LoginService. Las verificaciones en curso no guardan su resultado.
+    void invalidate(const std::string& token) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        ++generation;
+        auto it = cache.find(token);
+        if (it != cache.end()) {
+            erase(it);
+        }
+    }
+
+    // Llama a "callback" desde un trabajador cuando la verificación termina
+    void verify(const std::string& token, Callback callback) {
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            auto& callbacks = pending[token];
+            callbacks.push_back(std::move(callback));
+            if (callbacks.size() > 1) {
+                return;
+            }
+        }
+        net::post(workers, [this, token] {
+            verifyOnWorker(token);
+        });
+    }
+};
+
+class AsyncSocketServlet {
+private:
+    LoginService loginService;
+    net::thread_pool workers;
+    TokenVerifier tokenVerifier{loginService, workers};
+
+    static void completeConnection(net::ip::tcp::socket socket, std::optional<long> userId) {
         if (userId.has_value()) {
             auto asyncSocket = std::make_shared<AsyncSocket>(std::move(socket), userId.value());
             asyncSocket->start();
         } else {
             std::cerr << "Authentication failed. Connection rejected." << std::endl;
+            beast::error_code ignored;
+            socket.close(ignored);
+        }
+    }
+
+public:
+    explicit AsyncSocketServlet(std::size_t workerThreads = 4) : workers(workerThreads) {}
+
+    ~AsyncSocketServlet() {
+        workers.join();
+    }
+
+    // Debe llamarse al revocar un token para que no siga autenticando desde la caché
+    void revokeToken(const std::string& token) {
+        tokenVerifier.invalidate(token);
+    }
+
+    // No bloquea el hilo de E/S: la conexión se completa cuando se resuelve la autenticación
+    void handleConnection(net::ip::tcp::socket&& socket, const std::map<std::string, std::string>& params) {
+        auto tokenIt = params.find("token");
+        if (tokenIt == params.end()) {
+            completeConnection(std::move(socket), std::nullopt);
+            return;
+        }
+
+        if (auto cached = tokenVerifier.lookup(tokenIt->second)) {
+            completeConnection(std::move(socket), *cached);
+            return;
         }
+
+        auto pendingSocket = std::make_shared<net::ip::tcp::socket>(std::move(socket));
+        tokenVerifier.verify(tokenIt->second, [pendingSocket](std::optional<long> userId) {
+            // Se vuelve al strand del socket para completar la conexión
+            auto executor = pendingSocket->get_executor();
+            net::post(executor, [pendingSocket, userId] {
+                completeConnection(std::move(*pendingSocket), userId);
+            });
+        });
     }
 };
 
+// Bucle de aceptación continuo; cada socket aceptado recibe su propio strand
+void doAccept(net::ip::tcp::acceptor& acceptor, net::io_context& ioc, AsyncSocketServlet& servlet) {
+    acceptor.async_accept(net::make_strand(ioc), [
+        &acceptor, &ioc, &servlet
+    ](boost::system::error_code ec, net::ip::tcp::socket socket) {
+        if (!ec) {
+            std::map<std::string, std::string> params = { {"token", "valid_token"} };
+            servlet.handleConnection(std::move(socket), params);
+        } else {
+            std::cerr << "Accept error: " << ec.message() << std::endl;
+        }
+        doAccept(acceptor, ioc, servlet);
+    });
+}
+
 int main() {
     try {
-        net::io_context ioc;
+        unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+        net::io_context ioc(threadCount);
         net::ip::tcp::endpoint endpoint(net::ip::tcp::v4(), 8080);
         net::ip::tcp::acceptor acceptor(ioc, endpoint);
 
         AsyncSocketServlet servlet;
 
-        acceptor.async_accept([
-            &servlet
-        ](boost::system::error_code ec, net::ip::tcp::socket socket) {
-            if (!ec) {
-                std::map<std::string, std::string> params = { {"token", "valid_token"} };
-                servlet.handleConnection(std::move(socket), params);
-            } else {
-                std::cerr << "Accept error: " << ec.message() << std::endl;
-            }
-        });
+        doAccept(acceptor, ioc, servlet);
 
-        std::cout << "WebSocket server running on port 8080..." << std::endl;
+        std::cout << "WebSocket server running on port 8080 with " << threadCount << " threads..." << std::endl;
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < threadCount; ++i) {
+            threads.emplace_back([&ioc] { ioc.run(); });
+        }
         ioc.run();
+        for (auto& thread : threads) {
+            thread.join();
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
@@ -3,6 +3,22 @@
 #include <memory>
 #include <unordered_map>
 #include <stdexcept>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <typeindex>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ApiError.h"
 
 // Simulaciones de dependencias externas
 class StorageException : public std::runtime_error {
@@ -13,27 +29,549 @@ public:
 class PermissionsService {
 public:
     template <typename T>
-    void checkPermission(long userId, long objectId) {
+    Expected<void> checkPermission(long userId, long objectId) const {
         // Simula la validación de permisos
         if (userId != 1) {
-            throw std::runtime_error("Permission denied");
+            return ApiError{ErrorCode::Forbidden, objectId};
         }
+        return {};
     }
 
     template <typename T>
-    void checkEdit(long userId, bool isNew, bool skipReadonly) {
+    Expected<void> checkEdit(long userId, bool isNew, bool skipReadonly) const {
         // Simula la validación de permisos de edición
         if (userId != 1) {
-            throw std::runtime_error("Edit permission denied");
+            return ApiError{ErrorCode::Forbidden};
         }
+        return {};
     }
 };
 
+// Caché compartida (L2) de objetos inmutables por tipo
 class CacheManager {
+private:
+    std::mutex cacheMutex;
+    std::unordered_map<std::type_index, std::unordered_map<long, std::shared_ptr<const void>>> cache;
+    std::unordered_map<std::type_index, std::vector<std::function<void(long)>>> listeners;
+
 public:
+    template <typename T>
+    std::shared_ptr<const T> getObject(long objectId) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto& objects = cache[typeid(T)];
+        auto it = objects.find(objectId);
+        if (it != objects.end()) {
+            return std::static_pointer_cast<const T>(it->second);
+        }
+        return nullptr;
+    }
+
+    // Guarda el objeto solo si "valid" sigue siendo cierto bajo el bloqueo,
+    // para no reintroducir un valor invalidado mientras se cargaba
+    template <typename T>
+    void putObject(long objectId, std::shared_ptr<const T> object, const std::function<bool()>& valid) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (valid()) {
+            cache[typeid(T)][objectId] = std::move(object);
+        }
+    }
+
+    // Registra una función que se llama en cada invalidación de objetos del tipo T
+    template <typename T>
+    void addInvalidationListener(std::function<void(long)> listener) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        listeners[typeid(T)].push_back(std::move(listener));
+    }
+
+    // Los listeners se ejecutan bajo el bloqueo para que putObject no pueda colarse entre el borrado
+    // y el cambio de versión; solo deben hacer trabajo mínimo. El log va fuera del bloqueo.
     template <typename T>
     void invalidateObject(long objectId, const std::string& operation) {
-        std::cout << "Cache invalidated for object ID: " << objectId << ", operation: " << operation << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            auto objects = cache.find(typeid(T));
+            if (objects != cache.end()) {
+                objects->second.erase(objectId);
+            }
+            auto registered = listeners.find(typeid(T));
+            if (registered != listeners.end()) {
+                for (const auto& listener : registered->second) {
+                    listener(objectId);
+                }
+            }
+        }
+        std::cout << "Cache invalidated for object ID: " << objectId << ", operation: " << operation << '\n';
+    }
+};
+
+// Métricas de lectura de la caché de objetos (instantánea). La latencia se mide sobre una muestra
+// de las lecturas: sampledNanos / sampled.
+struct CacheMetrics {
+    unsigned long l1Hits = 0;
+    unsigned long l2Hits = 0;
+    unsigned long misses = 0;
+    unsigned long sampled = 0;
+    unsigned long sampledNanos = 0;
+
+    unsigned long requests() const {
+        return l1Hits + l2Hits + misses;
+    }
+
+    double hitRatio() const {
+        unsigned long total = requests();
+        return total == 0 ? 0.0 : static_cast<double>(l1Hits + l2Hits) / total;
+    }
+
+    double averageLatencyNanos() const {
+        return sampled == 0 ? 0.0 : static_cast<double>(sampledNanos) / sampled;
+    }
+};
+
+// Contadores repartidos por hilo: cada hilo incrementa su propia línea de caché y solo la lectura
+// de las métricas recorre y suma todas. Con más hilos que ranuras dos hilos comparten ranura, lo
+// que sigue siendo correcto porque los incrementos son atómicos.
+class ShardedCacheMetrics {
+private:
+    static constexpr std::size_t SHARDS = 64;
+
+    struct alignas(64) Shard {
+        std::atomic<unsigned long> l1Hits{0};
+        std::atomic<unsigned long> l2Hits{0};
+        std::atomic<unsigned long> misses{0};
+        std::atomic<unsigned long> sampled{0};
+        std::atomic<unsigned long> sampledNanos{0};
+    };
+
+    std::array<Shard, SHARDS> shards;
+
+    static std::size_t threadIndex() {
+        static std::atomic<std::size_t> nextIndex{0};
+        thread_local std::size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+
+public:
+    Shard& local() {
+        return shards[threadIndex()];
+    }
+
+    CacheMetrics snapshot() const {
+        CacheMetrics total;
+        for (const auto& shard : shards) {
+            total.l1Hits += shard.l1Hits.load(std::memory_order_relaxed);
+            total.l2Hits += shard.l2Hits.load(std::memory_order_relaxed);
+            total.misses += shard.misses.load(std::memory_order_relaxed);
+            total.sampled += shard.sampled.load(std::memory_order_relaxed);
+            total.sampledNanos += shard.sampledNanos.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+// Caché de lectura en dos niveles: L1 de mapeo directo por hilo delante de la L2 del CacheManager.
+// Cada ranura de L1 tiene una versión compartida que se incrementa al invalidar un ID de esa ranura,
+// de modo que las entradas de otros hilos quedan obsoletas sin tener que tocarlas.
+template <typename T>
+class ObjectCache {
+private:
+    static constexpr std::size_t L1_SIZE = 256;
+
+    // La entrada se asocia a la generación de la caché, no a su dirección, que puede reutilizarse
+    // tras destruirla; y guarda un weak_ptr para no mantener vivos objetos de una caché destruida
+    struct Entry {
+        std::uint64_t generation = 0;
+        long id = 0;
+        unsigned long version = 0;
+        std::weak_ptr<const T> value;
+    };
+
+    static std::uint64_t nextGeneration() {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    const std::uint64_t generation = nextGeneration();
+    CacheManager& cacheManager;
+    // Se cronometra una de cada LATENCY_SAMPLE lecturas de cada hilo; el resto no lee el reloj
+    static constexpr unsigned LATENCY_SAMPLE = 64;
+
+    std::array<std::atomic<unsigned long>, L1_SIZE> versions{};
+    ShardedCacheMetrics metrics;
+
+    static std::size_t slot(long id) {
+        return static_cast<std::size_t>(id) & (L1_SIZE - 1);
+    }
+
+    static std::array<Entry, L1_SIZE>& localEntries() {
+        thread_local std::array<Entry, L1_SIZE> entries;
+        return entries;
+    }
+
+    static bool sampleThisGet() {
+        thread_local unsigned counter = 0;
+        return ++counter % LATENCY_SAMPLE == 0;
+    }
+
+public:
+    explicit ObjectCache(CacheManager& cacheManager) : cacheManager(cacheManager) {
+        cacheManager.addInvalidationListener<T>([this](long id) {
+            versions[slot(id)].fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    ObjectCache(const ObjectCache&) = delete;
+    ObjectCache& operator=(const ObjectCache&) = delete;
+
+    // Devuelve el objeto desde L1, L2 o el cargador, en ese orden; nullptr si no existe
+    template <typename Loader>
+    std::shared_ptr<const T> get(long id, Loader loader) {
+        bool timed = sampleThisGet();
+        std::chrono::steady_clock::time_point start;
+        if (timed) {
+            start = std::chrono::steady_clock::now();
+        }
+        auto& counters = metrics.local();
+        auto& version = versions[slot(id)];
+        unsigned long current = version.load(std::memory_order_acquire);
+        Entry& entry = localEntries()[slot(id)];
+
+        std::shared_ptr<const T> value;
+        if (entry.generation == generation && entry.id == id && entry.version == current
+                && (value = entry.value.lock())) {
+            counters.l1Hits.fetch_add(1, std::memory_order_relaxed);
+        } else if ((value = cacheManager.getObject<T>(id))) {
+            counters.l2Hits.fetch_add(1, std::memory_order_relaxed);
+        } else if ((value = loader(id))) {
+            cacheManager.putObject<T>(id, value, [&] {
+                return version.load(std::memory_order_acquire) == current;
+            });
+            counters.misses.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            counters.misses.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (value) {
+            entry = {generation, id, current, value};
+        }
+        if (timed) {
+            counters.sampled.fetch_add(1, std::memory_order_relaxed);
+            counters.sampledNanos.fetch_add(static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    CacheMetrics getMetrics() const {
+        return metrics.snapshot();
+    }
+};
+
+// Generador de IDs monótono por tipo. Reserva bloques de IDs y persiste el límite superior
+// reservado (marca de agua) antes de entregarlos, así tras un reinicio se continúa desde la
+// marca y nunca se repite un ID, aunque queden huecos de IDs no usados.
+class IdAllocator {
+private:
+    static constexpr long BLOCK_SIZE = 1000;
+
+    std::string watermarkFile;
+    std::atomic<long> next;
+    std::atomic<long> reserved;
+    std::mutex reserveMutex;
+
+    // Sin fichero se empieza de cero; un fichero presente pero ilegible o corrupto impide arrancar,
+    // porque reiniciar la secuencia entregaría IDs repetidos
+    static long readWatermark(const std::string& file) {
+        if (file.empty() || !std::filesystem::exists(file)) {
+            return 0;
+        }
+        std::ifstream input(file);
+        long watermark = 0;
+        if (!input || !(input >> watermark) || watermark < 0) {
+            throw StorageException("Unreadable id watermark: " + file);
+        }
+        input >> std::ws;
+        if (!input.eof()) {
+            throw StorageException("Corrupt id watermark: " + file);
+        }
+        return watermark;
+    }
+
+    void persistWatermark(long watermark) {
+        if (watermarkFile.empty()) {
+            return;
+        }
+        // Escribir, fsync del temporal, rename y fsync del directorio: tras una caída se ve la marca
+        // anterior o la nueva, nunca un fichero vacío ni un rename perdido
+        std::string tmpFile = watermarkFile + ".tmp";
+        std::string content = std::to_string(watermark) + "\n";
+        int fd = ::open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw StorageException("Failed to persist id watermark: " + watermarkFile);
+        }
+        bool written = ::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size())
+                && ::fsync(fd) == 0;
+        written = ::close(fd) == 0 && written;
+        if (!written) {
+            throw StorageException("Failed to persist id watermark: " + watermarkFile);
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmpFile, watermarkFile, ec);
+        if (ec) {
+            throw StorageException("Failed to persist id watermark: " + watermarkFile + ": " + ec.message());
+        }
+        std::filesystem::path directory = std::filesystem::path(watermarkFile).parent_path();
+        int dirFd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd < 0 || ::fsync(dirFd) != 0) {
+            if (dirFd >= 0) {
+                ::close(dirFd);
+            }
+            throw StorageException("Failed to sync id watermark directory: " + watermarkFile);
+        }
+        ::close(dirFd);
+    }
+
+    void reserveBlock(long id) {
+        std::lock_guard<std::mutex> lock(reserveMutex);
+        long current = reserved.load(std::memory_order_acquire);
+        if (id < current) {
+            return;
+        }
+        long watermark = std::max(current, id + 1) + BLOCK_SIZE;
+        persistWatermark(watermark);
+        reserved.store(watermark, std::memory_order_release);
+    }
+
+public:
+    // minimumId permite arrancar por encima de los IDs ya presentes en el almacenamiento
+    explicit IdAllocator(const std::string& watermarkFile, long minimumId = 1)
+            : watermarkFile(watermarkFile) {
+        long start = std::max(readWatermark(watermarkFile), minimumId);
+        next.store(start);
+        reserved.store(start);
+    }
+
+    long nextId() {
+        long id = next.fetch_add(1, std::memory_order_relaxed);
+        while (id >= reserved.load(std::memory_order_acquire)) {
+            reserveBlock(id);
+        }
+        return id;
+    }
+};
+
+// Almacenamiento repartido en fragmentos con su propio bloqueo, sin bloqueo global
+template <typename T>
+class ShardedStorage {
+private:
+    static constexpr std::size_t SHARD_COUNT = 64;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<long, std::shared_ptr<const T>> objects;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+
+    Shard& shard(long id) {
+        return shards[static_cast<std::size_t>(id) % SHARD_COUNT];
+    }
+
+public:
+    std::shared_ptr<const T> find(long id) {
+        Shard& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.objects.find(id);
+        return it != s.objects.end() ? it->second : nullptr;
+    }
+
+    bool insert(long id, std::shared_ptr<const T> object) {
+        Shard& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.objects.emplace(id, std::move(object)).second;
+    }
+
+    bool replace(long id, std::shared_ptr<const T> object) {
+        Shard& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.objects.find(id);
+        if (it == s.objects.end()) {
+            return false;
+        }
+        it->second = std::move(object);
+        return true;
+    }
+
+    bool erase(long id) {
+        Shard& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.objects.erase(id) > 0;
+    }
+};
+
+enum class MutationType {
+    Create,
+    Update,
+    Remove
+};
+
+inline const char* operationName(MutationType type) {
+    switch (type) {
+        case MutationType::Create: return "CREATE";
+        case MutationType::Update: return "UPDATE";
+        default: return "DELETE";
+    }
+}
+
+template <typename T>
+struct PendingMutation {
+    MutationType type;
+    std::shared_ptr<const T> object;
+};
+
+// Métricas de la cola de escritura diferida
+struct WriteBehindMetrics {
+    std::atomic<unsigned long> queueDepth{0};
+    std::atomic<unsigned long> coalesced{0};
+    std::atomic<unsigned long> flushes{0};
+    std::atomic<unsigned long> flushedMutations{0};
+    std::atomic<unsigned long> lastFlushNanos{0};
+    std::atomic<unsigned long> totalFlushNanos{0};
+};
+
+struct WriteBehindOptions {
+    bool enabled = false;
+    std::size_t batchSize = 500;
+    std::chrono::milliseconds flushInterval{200};
+};
+
+// Cola de escritura diferida por tipo. Las mutaciones se agrupan por ID (la última actualización
+// gana, una creación seguida de un borrado se anula) y se vuelcan por lotes al alcanzar el tamaño
+// de lote o el intervalo de tiempo. Las mutaciones pendientes o en vuelo se consultan en las
+// lecturas para que quien escribe vea siempre sus propios cambios.
+template <typename T>
+class WriteBehindQueue {
+public:
+    using Batch = std::unordered_map<long, PendingMutation<T>>;
+    using FlushHandler = std::function<void(const Batch&)>;
+
+private:
+    std::size_t batchSize;
+    std::chrono::milliseconds flushInterval;
+    FlushHandler flushHandler;
+    WriteBehindMetrics metrics;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    Batch pending;
+    Batch inflight;
+    bool stopping = false;
+
+    std::mutex flushMutex;
+    std::thread worker;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            condition.wait_for(lock, flushInterval, [this] {
+                return stopping || pending.size() >= batchSize;
+            });
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+public:
+    WriteBehindQueue(const WriteBehindOptions& options, FlushHandler flushHandler)
+            : batchSize(options.batchSize), flushInterval(options.flushInterval),
+              flushHandler(std::move(flushHandler)), worker(&WriteBehindQueue::run, this) {}
+
+    ~WriteBehindQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_one();
+        worker.join();
+        flush();
+    }
+
+    // Encola una mutación agrupándola con la pendiente del mismo ID. Devuelve false si el objeto
+    // no existe: "exists" se consulta solo cuando no hay mutaciones pendientes ni en vuelo.
+    template <typename Exists>
+    bool enqueue(long id, MutationType type, std::shared_ptr<const T> object, Exists exists) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = pending.find(id);
+        if (it == pending.end()) {
+            if (type != MutationType::Create) {
+                auto flying = inflight.find(id);
+                bool found = flying != inflight.end() ? flying->second.type != MutationType::Remove : exists();
+                if (!found) {
+                    return false;
+                }
+            }
+            pending.emplace(id, PendingMutation<T>{type, std::move(object)});
+        } else if (it->second.type == MutationType::Remove) {
+            return false;
+        } else if (type == MutationType::Remove && it->second.type == MutationType::Create) {
+            pending.erase(it);
+            metrics.coalesced++;
+        } else {
+            if (type == MutationType::Remove) {
+                it->second.type = MutationType::Remove;
+            }
+            it->second.object = std::move(object);
+            metrics.coalesced++;
+        }
+
+        metrics.queueDepth = pending.size();
+        if (pending.size() >= batchSize) {
+            lock.unlock();
+            condition.notify_one();
+        }
+        return true;
+    }
+
+    // Última mutación todavía no aplicada al almacenamiento para el ID
+    std::optional<PendingMutation<T>> lookup(long id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(id);
+        if (it != pending.end()) {
+            return it->second;
+        }
+        it = inflight.find(id);
+        if (it != inflight.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> flushLock(flushMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pending.empty()) {
+                return;
+            }
+            inflight.swap(pending);
+            metrics.queueDepth = 0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        flushHandler(inflight);
+        unsigned long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        metrics.flushes++;
+        metrics.flushedMutations += inflight.size();
+        metrics.lastFlushNanos = nanos;
+        metrics.totalFlushNanos += nanos;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        inflight.clear();
+    }
+
+    const WriteBehindMetrics& getMetrics() const {
+        return metrics;
     }
 };
 
@@ -43,50 +581,139 @@ class BaseObjectResource {
 private:
     PermissionsService permissionsService;
     CacheManager cacheManager;
-    std::unordered_map<long, T> storage;
+    ObjectCache<T> objectCache{cacheManager};
+    ShardedStorage<T> storage;
+    IdAllocator idAllocator;
+    std::unique_ptr<WriteBehindQueue<T>> writeBehind;
+
+    void applyBatch(const typename WriteBehindQueue<T>::Batch& batch) {
+        for (const auto& [id, mutation] : batch) {
+            switch (mutation.type) {
+                case MutationType::Create:
+                    storage.insert(id, mutation.object);
+                    break;
+                case MutationType::Update:
+                    storage.replace(id, mutation.object);
+                    break;
+                case MutationType::Remove:
+                    storage.erase(id);
+                    break;
+            }
+            // Un ID recién creado no puede estar en caché: las ausencias no se cachean
+            if (mutation.type != MutationType::Create) {
+                cacheManager.invalidateObject<T>(id, operationName(mutation.type));
+            }
+        }
+    }
 
 public:
-    T getSingle(long userId, long id) {
-        permissionsService.checkPermission<T>(userId, id);
-        if (storage.find(id) != storage.end()) {
-            return storage[id];
-        } else {
-            throw StorageException("Object not found");
+    // sequenceFile guarda la marca de agua de IDs del tipo; vacío para no persistirla
+    explicit BaseObjectResource(const std::string& sequenceFile, const WriteBehindOptions& options = {})
+            : idAllocator(sequenceFile) {
+        if (options.enabled) {
+            writeBehind = std::make_unique<WriteBehindQueue<T>>(options, [this](const auto& batch) {
+                applyBatch(batch);
+            });
+        }
+    }
+
+    // Devuelve un manejador inmutable compartido en lugar de una copia
+    Expected<std::shared_ptr<const T>> getSingle(long userId, long id) {
+        if (auto allowed = permissionsService.checkPermission<T>(userId, id); !allowed) {
+            return allowed.error();
+        }
+        if (writeBehind) {
+            if (auto mutation = writeBehind->lookup(id)) {
+                if (mutation->type == MutationType::Remove) {
+                    return ApiError{ErrorCode::NotFound, id};
+                }
+                return mutation->object;
+            }
+        }
+        auto object = objectCache.get(id, [this](long objectId) {
+            return storage.find(objectId);
+        });
+        if (!object) {
+            return ApiError{ErrorCode::NotFound, id};
+        }
+        return object;
+    }
+
+    CacheMetrics getCacheMetrics() const {
+        return objectCache.getMetrics();
+    }
+
+    // Vuelca de inmediato las mutaciones diferidas pendientes
+    void flush() {
+        if (writeBehind) {
+            writeBehind->flush();
         }
     }
 
-    void add(long userId, const T& entity) {
-        permissionsService.checkEdit<T>(userId, true, false);
-        long id = storage.size() + 1;
+    const WriteBehindMetrics* getWriteBehindMetrics() const {
+        return writeBehind ? &writeBehind->getMetrics() : nullptr;
+    }
+
+    // Devuelve el ID asignado
+    Expected<long> add(long userId, const T& entity) {
+        if (auto allowed = permissionsService.checkEdit<T>(userId, true, false); !allowed) {
+            return allowed.error();
+        }
+        long id = idAllocator.nextId();
         T newEntity = entity;
         newEntity.setId(id);
-        storage[id] = newEntity;
-        cacheManager.invalidateObject<T>(id, "CREATE");
+        auto object = std::make_shared<const T>(newEntity);
+        if (writeBehind) {
+            writeBehind->enqueue(id, MutationType::Create, std::move(object), [] { return true; });
+        } else {
+            // Sin invalidación: el ID es nuevo y las ausencias no se cachean, así que no hay nada que borrar
+            storage.insert(id, std::move(object));
+        }
         std::cout << "Object created with ID: " << id << std::endl;
+        return id;
     }
 
-    void update(long userId, const T& entity) {
-        permissionsService.checkPermission<T>(userId, entity.getId());
-        permissionsService.checkEdit<T>(userId, false, false);
-        if (storage.find(entity.getId()) != storage.end()) {
-            storage[entity.getId()] = entity;
-            cacheManager.invalidateObject<T>(entity.getId(), "UPDATE");
+    Expected<void> update(long userId, const T& entity) {
+        if (auto allowed = permissionsService.checkPermission<T>(userId, entity.getId()); !allowed) {
+            return allowed.error();
+        }
+        if (auto allowed = permissionsService.checkEdit<T>(userId, false, false); !allowed) {
+            return allowed.error();
+        }
+        auto object = std::make_shared<const T>(entity);
+        bool updated = writeBehind
+                ? writeBehind->enqueue(entity.getId(), MutationType::Update, std::move(object),
+                                       [&] { return storage.find(entity.getId()) != nullptr; })
+                : storage.replace(entity.getId(), std::move(object));
+        if (updated) {
+            if (!writeBehind) {
+                cacheManager.invalidateObject<T>(entity.getId(), "UPDATE");
+            }
             std::cout << "Object updated with ID: " << entity.getId() << std::endl;
-        } else {
-            throw StorageException("Object not found");
+            return {};
         }
+        return ApiError{ErrorCode::NotFound, entity.getId()};
     }
 
-    void remove(long userId, long id) {
-        permissionsService.checkPermission<T>(userId, id);
-        permissionsService.checkEdit<T>(userId, false, false);
-        if (storage.find(id) != storage.end()) {
-            storage.erase(id);
-            cacheManager.invalidateObject<T>(id, "DELETE");
+    Expected<void> remove(long userId, long id) {
+        if (auto allowed = permissionsService.checkPermission<T>(userId, id); !allowed) {
+            return allowed.error();
+        }
+        if (auto allowed = permissionsService.checkEdit<T>(userId, false, false); !allowed) {
+            return allowed.error();
+        }
+        bool removed = writeBehind
+                ? writeBehind->enqueue(id, MutationType::Remove, nullptr,
+                                       [&] { return storage.find(id) != nullptr; })
+                : storage.erase(id);
+        if (removed) {
+            if (!writeBehind) {
+                cacheManager.invalidateObject<T>(id, "DELETE");
+            }
             std::cout << "Object removed with ID: " << id << std::endl;
-        } else {
-            throw StorageException("Object not found");
+            return {};
         }
+        return ApiError{ErrorCode::NotFound, id};
     }
 };
 
@@ -107,7 +734,9 @@ public:
 
 int main() {
     try {
-        BaseObjectResource<BaseModel> resource;
+        auto sequenceFile = std::filesystem::temp_directory_path() / "BaseModel.seq";
+        std::filesystem::remove(sequenceFile);
+        BaseObjectResource<BaseModel> resource(sequenceFile.string());
         BaseModel obj;
 
         // Agregar un objeto
@@ -115,13 +744,42 @@ int main() {
 
         // Obtener un objeto
         auto fetched = resource.getSingle(1, 1);
-        std::cout << "Fetched object ID: " << fetched.getId() << std::endl;
+        if (!fetched) {
+            std::cerr << "Error: " << fetched.error().message() << std::endl;
+            return 1;
+        }
+        std::cout << "Fetched object ID: " << (*fetched)->getId() << std::endl;
+
+        // Lecturas repetidas servidas desde la caché L1; la latencia se muestrea entre ellas
+        for (int i = 0; i < 100; ++i) {
+            resource.getSingle(1, 1);
+        }
 
         // Actualizar un objeto
-        resource.update(1, fetched);
+        resource.update(1, **fetched);
+
+        auto metrics = resource.getCacheMetrics();
+        std::cout << "Cache hit ratio: " << metrics.hitRatio()
+                  << ", average latency: " << metrics.averageLatencyNanos() << " ns" << std::endl;
 
         // Eliminar un objeto
         resource.remove(1, 1);
+
+        // Un usuario sin permisos recibe un ApiError, no una excepción
+        if (auto denied = resource.getSingle(2, 1); !denied) {
+            std::cout << "Denied: " << denied.error().message() << std::endl;
+        }
+
+        // Modo de escritura diferida: la creación y el borrado se anulan antes de volcarse
+        WriteBehindOptions options;
+        options.enabled = true;
+        BaseObjectResource<BaseModel> deferred("", options);
+        deferred.add(1, obj);
+        auto pending = deferred.getSingle(1, 1);
+        deferred.update(1, **pending);
+        deferred.remove(1, 1);
+        deferred.flush();
+        std::cout << "Coalesced mutations: " << deferred.getWriteBehindMetrics()->coalesced << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
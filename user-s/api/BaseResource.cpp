@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include "ApiError.h"
 
 class SecurityContext {
 private:
@@ -16,10 +17,11 @@ public:
 
 class PermissionsService {
 public:
-    void checkPermission(long userId, const std::string& operation) {
+    Expected<void> checkPermission(long userId, const std::string& operation) const {
         if (userId != 1) {
-            throw std::runtime_error("Permission denied for operation: " + operation);
+            return ApiError{ErrorCode::Forbidden, 0, operation};
         }
+        return {};
     }
 };
 
@@ -35,22 +37,19 @@ public:
         return securityContext.getUserId();
     }
 
-    void checkAccess(const std::string& operation) {
-        permissionsService.checkPermission(securityContext.getUserId(), operation);
+    Expected<void> checkAccess(const std::string& operation) const {
+        return permissionsService.checkPermission(securityContext.getUserId(), operation);
     }
 };
 
 int main() {
-    try {
-        BaseResource resource(1); // Usuario con ID 1
+    BaseResource resource(1); // Usuario con ID 1
 
-        std::cout << "User ID: " << resource.getUserId() << std::endl;
+    std::cout << "User ID: " << resource.getUserId() << std::endl;
 
-        // Comprobación de permisos
-        resource.checkAccess("read");
-
-    } catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+    // Comprobación de permisos
+    if (auto result = resource.checkAccess("read"); !result) {
+        std::cerr << "Error: " << result.error().message() << std::endl;
     }
 
     return 0;
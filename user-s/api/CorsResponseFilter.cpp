@@ -3,6 +3,12 @@
 #include <map>
 #include <set>
 #include <optional>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 class Config {
 public:
@@ -11,44 +17,156 @@ public:
     }
 };
 
+// Bloque de cabeceras inmutable, compartido entre todas las respuestas que lo usan
+using HeaderBlock = std::vector<std::pair<std::string, std::string>>;
+
+// Respuesta completa a un preflight OPTIONS, con las cabeceras ya serializadas para escribirlas tal cual
+struct PreflightResponse {
+    int status;
+    HeaderBlock headers;
+    std::string rendered;
+};
+
 class CorsResponseFilter {
 private:
-    std::string allowed;
-
     const std::string ORIGIN_ALL = "*";
     const std::string HEADERS_ALL = "origin, content-type, accept, authorization";
     const std::string METHODS_ALL = "GET, POST, PUT, DELETE, OPTIONS";
+    const std::string PREFLIGHT_MAX_AGE = "86400";
+
+    // Lista de orígenes permitidos, normalizada una sola vez al construir el filtro. El conjunto
+    // guarda vistas sobre originNames, que no cambia tras el constructor, para buscar el origen de
+    // la petición sin construir un std::string.
+    bool allowAll = false;
+    std::vector<std::string> originNames;
+    std::unordered_set<std::string_view> allowedOrigins;
+
+    // Bloques precalculados: sin Origin en la petición, y cabeceras comunes cuando se devuelve el origen
+    HeaderBlock originAllBlock;
+    HeaderBlock matchedBlock;
+
+    std::shared_ptr<const PreflightResponse> preflightDenied;
+    std::shared_ptr<const PreflightResponse> preflightNoOrigin;
+    // Solo para la lista explícita, completa desde el constructor y de solo lectura después
+    std::unordered_map<std::string_view, std::shared_ptr<const PreflightResponse>> preflightCache;
+
+    static std::string_view trim(std::string_view value) {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+        return value;
+    }
+
+    // Los orígenes se comparan sin la barra final que a veces se escribe en la configuración
+    static std::string_view normalizeOrigin(std::string_view origin) {
+        origin = trim(origin);
+        if (origin.size() > 1 && origin.back() == '/') {
+            origin.remove_suffix(1);
+        }
+        return origin;
+    }
+
+    void parseAllowed(std::string_view list) {
+        while (!list.empty()) {
+            auto separator = list.find_first_of(", ");
+            auto origin = normalizeOrigin(list.substr(0, separator));
+            list.remove_prefix(separator == std::string_view::npos ? list.size() : separator + 1);
+            if (origin == ORIGIN_ALL) {
+                allowAll = true;
+            } else if (!origin.empty()) {
+                originNames.emplace_back(origin);
+            }
+        }
+        allowedOrigins.insert(originNames.begin(), originNames.end());
+    }
+
+    bool isAllowed(std::string_view origin) const {
+        return allowAll || allowedOrigins.count(normalizeOrigin(origin)) > 0;
+    }
+
+    static std::shared_ptr<const PreflightResponse> makePreflight(int status, HeaderBlock headers) {
+        auto response = std::make_shared<PreflightResponse>();
+        response->status = status;
+        response->headers = std::move(headers);
+        for (const auto& header : response->headers) {
+            response->rendered += header.first + ": " + header.second + "\r\n";
+        }
+        return response;
+    }
+
+    std::shared_ptr<const PreflightResponse> makeOriginPreflight(std::string_view origin) const {
+        HeaderBlock headers = matchedBlock;
+        headers.emplace_back("Access-Control-Allow-Origin", std::string(origin));
+        headers.emplace_back("Access-Control-Max-Age", PREFLIGHT_MAX_AGE);
+        return makePreflight(204, std::move(headers));
+    }
+
+    static void apply(const HeaderBlock& block, std::map<std::string, std::string>& responseHeaders) {
+        for (const auto& header : block) {
+            responseHeaders.try_emplace(header.first, header.second);
+        }
+    }
 
 public:
     CorsResponseFilter(const Config& config) {
         auto origin = config.getWebOrigin();
-        allowed = origin.value_or(ORIGIN_ALL);
+        parseAllowed(origin.value_or(ORIGIN_ALL));
+
+        originAllBlock = {
+            {"Access-Control-Allow-Headers", HEADERS_ALL},
+            {"Access-Control-Allow-Credentials", "true"},
+            {"Access-Control-Allow-Methods", METHODS_ALL},
+            {"Access-Control-Allow-Origin", ORIGIN_ALL},
+        };
+        matchedBlock = {
+            {"Access-Control-Allow-Headers", HEADERS_ALL},
+            {"Access-Control-Allow-Credentials", "true"},
+            {"Access-Control-Allow-Methods", METHODS_ALL},
+            {"Vary", "Origin"},
+        };
+
+        HeaderBlock noOrigin = originAllBlock;
+        noOrigin.emplace_back("Access-Control-Max-Age", PREFLIGHT_MAX_AGE);
+        preflightNoOrigin = makePreflight(204, std::move(noOrigin));
+        preflightDenied = makePreflight(403, {{"Vary", "Origin"}});
+
+        // Con una lista explícita, todas las respuestas de preflight se conocen de antemano
+        for (const auto& allowedOrigin : allowedOrigins) {
+            preflightCache.emplace(allowedOrigin, makeOriginPreflight(allowedOrigin));
+        }
     }
 
     void filter(const std::map<std::string, std::string>& requestHeaders, std::map<std::string, std::string>& responseHeaders) {
-        if (responseHeaders.find("Access-Control-Allow-Headers") == responseHeaders.end()) {
-            responseHeaders["Access-Control-Allow-Headers"] = HEADERS_ALL;
+        auto originIt = requestHeaders.find("Origin");
+        if (originIt == requestHeaders.end()) {
+            apply(originAllBlock, responseHeaders);
+            return;
         }
 
-        if (responseHeaders.find("Access-Control-Allow-Credentials") == responseHeaders.end()) {
-            responseHeaders["Access-Control-Allow-Credentials"] = "true";
+        apply(matchedBlock, responseHeaders);
+        const std::string& origin = originIt->second;
+        if (isAllowed(origin)) {
+            responseHeaders.try_emplace("Access-Control-Allow-Origin", origin);
         }
+    }
 
-        if (responseHeaders.find("Access-Control-Allow-Methods") == responseHeaders.end()) {
-            responseHeaders["Access-Control-Allow-Methods"] = METHODS_ALL;
+    // Respuesta a OPTIONS servida desde caché, sin pasar por el recurso
+    std::shared_ptr<const PreflightResponse> preflight(const std::map<std::string, std::string>& requestHeaders) const {
+        auto originIt = requestHeaders.find("Origin");
+        if (originIt == requestHeaders.end()) {
+            return preflightNoOrigin;
         }
-
-        if (responseHeaders.find("Access-Control-Allow-Origin") == responseHeaders.end()) {
-            auto originIt = requestHeaders.find("Origin");
-            if (originIt == requestHeaders.end()) {
-                responseHeaders["Access-Control-Allow-Origin"] = ORIGIN_ALL;
-            } else {
-                const std::string& origin = originIt->second;
-                if (allowed == ORIGIN_ALL || allowed.find(origin) != std::string::npos) {
-                    responseHeaders["Access-Control-Allow-Origin"] = origin;
-                }
-            }
+        const std::string& origin = originIt->second;
+        auto it = preflightCache.find(normalizeOrigin(origin));
+        if (it != preflightCache.end()) {
+            return it->second;
+        }
+        if (!allowAll) {
+            return preflightDenied;
         }
+
+        // Con "*" se acepta cualquier origen y se devuelve tal cual. No se cachea: el cliente elige
+        // el origen, y guardarlo llenaría la caché con valores arbitrarios.
+        return makeOriginPreflight(origin);
     }
 };
 
@@ -71,5 +189,9 @@ int main() {
         std::cout << header.first << ": " << header.second << std::endl;
     }
 
+    // Preflight OPTIONS servido desde caché
+    auto preflight = corsFilter.preflight(requestHeaders);
+    std::cout << "Preflight " << preflight->status << std::endl << preflight->rendered;
+
     return 0;
 }
@@ -1,46 +1,46 @@
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <optional>
-#include <iomanip>
 #include <ctime>
+#include <type_traits>
+#include "DateUtil.h"
 
-class DateUtil {
+// Convertidor de parámetros de fecha para std::tm (formato "YYYY-MM-DD HH:MM:SS") y EpochMillis
+// (ISO-8601); para otros tipos no hay conversión y el proveedor devuelve nullopt
+template <typename T>
+class DateParameterConverter {};
+
+template <>
+class DateParameterConverter<std::tm> {
 public:
-    static std::optional<std::tm> parseDate(const std::string& value) {
-        std::tm tm = {};
-        std::istringstream ss(value);
-        ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-        if (ss.fail()) {
-            return std::nullopt;
-        }
-        return tm;
+    std::optional<std::tm> fromString(std::string_view value) {
+        return DateUtil::parseDate(value);
     }
 
-    static std::string formatDate(const std::tm& value) {
-        std::ostringstream ss;
-        ss << std::put_time(&value, "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+    std::string toString(const std::tm& value) {
+        return DateUtil::formatDate(value);
     }
 };
 
-class DateParameterConverter {
+template <>
+class DateParameterConverter<EpochMillis> {
 public:
-    std::optional<std::tm> fromString(const std::string& value) {
-        return DateUtil::parseDate(value);
+    std::optional<EpochMillis> fromString(std::string_view value) {
+        return DateUtil::parseIso(value);
     }
 
-    std::string toString(const std::tm& value) {
-        return DateUtil::formatDate(value);
+    std::string toString(EpochMillis value) {
+        return DateUtil::formatIso(value);
     }
 };
 
 class DateParameterConverterProvider {
 public:
     template <typename T>
-    std::optional<DateParameterConverter> getConverter() {
-        if (typeid(T) == typeid(std::tm)) {
-            return DateParameterConverter();
+    std::optional<DateParameterConverter<T>> getConverter() {
+        if constexpr (std::is_same_v<T, std::tm> || std::is_same_v<T, EpochMillis>) {
+            return DateParameterConverter<T>();
         }
         return std::nullopt;
     }
@@ -50,12 +50,23 @@ int main() {
     DateParameterConverterProvider provider;
 
     // Obtener un convertidor para std::tm
-    auto converter = provider.getConverter<std::tm>();
+    auto tmConverter = provider.getConverter<std::tm>();
+    if (tmConverter) {
+        auto parsedDate = tmConverter->fromString("2025-01-21 15:30:00");
+        if (parsedDate) {
+            std::cout << "Parsed Date: " << tmConverter->toString(*parsedDate) << std::endl;
+        } else {
+            std::cerr << "Failed to parse date." << std::endl;
+        }
+    }
+
+    // Obtener un convertidor para fechas en milisegundos
+    auto converter = provider.getConverter<EpochMillis>();
     if (converter) {
         // Convertir cadena a fecha
-        auto parsedDate = converter->fromString("2025-01-21 15:30:00");
+        auto parsedDate = converter->fromString("2025-01-21T15:30:00.250+01:00");
         if (parsedDate) {
-            std::cout << "Parsed Date: " << DateUtil::formatDate(*parsedDate) << std::endl;
+            std::cout << "Parsed Date: " << *parsedDate << " ms" << std::endl;
         } else {
             std::cerr << "Failed to parse date." << std::endl;
         }
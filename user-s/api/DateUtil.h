@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Milisegundos desde 1970-01-01T00:00:00Z
+using EpochMillis = std::int64_t;
+
+// Parser y formateador ISO-8601/RFC-3339 escritos a mano: sin streams, sin locale y sobre
+// string_view. Acepta "YYYY-MM-DD", "YYYY-MM-DD[T| ]HH:MM[:SS[.fracción]][Z|±HH[:MM]]";
+// sin zona se interpreta UTC. Como hacía std::get_time, mes, día, hora, minuto y segundo admiten
+// uno o dos dígitos ("2025-1-5 8:05:00").
+class DateUtil {
+private:
+    // Días desde la época para una fecha civil (algoritmo days_from_civil de H. Hinnant)
+    static std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+        unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+        unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+    }
+
+    static void civilFromDays(std::int64_t days, std::int64_t& year, unsigned& month, unsigned& day) {
+        days += 719468;
+        std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+        unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        unsigned monthPrime = (5 * dayOfYear + 2) / 153;
+        day = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+        month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+        year = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2);
+    }
+
+    static bool isLeap(std::int64_t year) {
+        return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    }
+
+    static unsigned daysInMonth(std::int64_t year, unsigned month) {
+        static constexpr unsigned DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && isLeap(year) ? 29 : DAYS[month - 1];
+    }
+
+    // Lee exactamente "count" dígitos desde "position"
+    static bool digits(std::string_view value, std::size_t position, std::size_t count, unsigned& result) {
+        if (position + count > value.size()) {
+            return false;
+        }
+        result = 0;
+        for (std::size_t i = position; i < position + count; ++i) {
+            unsigned digit = static_cast<unsigned char>(value[i]) - '0';
+            if (digit > 9) {
+                return false;
+            }
+            result = result * 10 + digit;
+        }
+        return true;
+    }
+
+    // Lee uno o dos dígitos desde "position" y avanza la posición tras ellos
+    static bool field(std::string_view value, std::size_t& position, unsigned& result) {
+        std::size_t count = 0;
+        result = 0;
+        while (count < 2 && position < value.size() && static_cast<unsigned>(value[position] - '0') <= 9) {
+            result = result * 10 + static_cast<unsigned>(value[position] - '0');
+            ++position;
+            ++count;
+        }
+        return count > 0;
+    }
+
+    static void writeDigits(char* out, unsigned value, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+public:
+    static std::optional<EpochMillis> parseIso(std::string_view value) {
+        unsigned year, month, day;
+        std::size_t position = 5;
+        if (!digits(value, 0, 4, year) || value.size() < 5 || value[4] != '-'
+                || !field(value, position, month) || position >= value.size() || value[position++] != '-'
+                || !field(value, position, day)
+                || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+            return std::nullopt;
+        }
+        std::int64_t millis = daysFromCivil(year, month, day) * 86400000;
+        if (position == value.size()) {
+            return millis;
+        }
+
+        char separator = value[position++];
+        unsigned hour, minute, second = 0;
+        if ((separator != 'T' && separator != 't' && separator != ' ')
+                || !field(value, position, hour) || position >= value.size() || value[position++] != ':'
+                || !field(value, position, minute) || hour > 23 || minute > 59) {
+            return std::nullopt;
+        }
+        if (position < value.size() && value[position] == ':') {
+            ++position;
+            // Se admite 60 para segundos intercalares, que se tratan como el segundo siguiente
+            if (!field(value, position, second) || second > 60) {
+                return std::nullopt;
+            }
+        }
+        millis += (hour * 3600 + minute * 60 + second) * std::int64_t{1000};
+
+        if (position < value.size() && (value[position] == '.' || value[position] == ',')) {
+            std::size_t start = ++position;
+            unsigned fraction = 0;
+            while (position < value.size() && static_cast<unsigned>(value[position] - '0') <= 9) {
+                // Solo cuentan los milisegundos; el resto de la precisión se trunca
+                if (position - start < 3) {
+                    fraction = fraction * 10 + static_cast<unsigned>(value[position] - '0');
+                }
+                ++position;
+            }
+            if (position == start) {
+                return std::nullopt;
+            }
+            for (std::size_t scale = position - start; scale < 3; ++scale) {
+                fraction *= 10;
+            }
+            millis += fraction;
+        }
+
+        if (position == value.size()) {
+            return millis;
+        }
+        char zone = value[position];
+        if ((zone == 'Z' || zone == 'z') && position + 1 == value.size()) {
+            return millis;
+        }
+        if (zone != '+' && zone != '-') {
+            return std::nullopt;
+        }
+        unsigned offsetHours, offsetMinutes = 0;
+        if (!digits(value, position + 1, 2, offsetHours)) {
+            return std::nullopt;
+        }
+        position += 3;
+        if (position < value.size()) {
+            position += value[position] == ':';
+            if (!digits(value, position, 2, offsetMinutes)) {
+                return std::nullopt;
+            }
+            position += 2;
+        }
+        if (position != value.size() || offsetHours > 23 || offsetMinutes > 59) {
+            return std::nullopt;
+        }
+        std::int64_t offset = (offsetHours * 60 + offsetMinutes) * std::int64_t{60000};
+        return zone == '+' ? millis - offset : millis + offset;
+    }
+
+    // Longitud máxima de formatIso
+    static constexpr std::size_t ISO_LENGTH = 24;
+
+    // "YYYY-MM-DDTHH:MM:SS.mmmZ" en UTC; los milisegundos se omiten si son cero
+    // ("YYYY-MM-DDTHH:MM:SSZ"), así que las marcas de segundo exacto salen como se recibieron.
+    // Lanza std::runtime_error si el año no cabe en cuatro dígitos (fuera de 0000-9999).
+    static std::string formatIso(EpochMillis value) {
+        char buffer[ISO_LENGTH];
+        return std::string(buffer, formatIso(value, buffer));
+    }
+
+    // Escribe hasta ISO_LENGTH caracteres en "buffer" sin reservar memoria y devuelve cuántos
+    static std::size_t formatIso(EpochMillis value, char* buffer) {
+        std::int64_t days = value >= 0 ? value / 86400000 : (value - 86399999) / 86400000;
+        std::int64_t millisOfDay = value - days * 86400000;
+        std::int64_t year;
+        unsigned month, day;
+        civilFromDays(days, year, month, day);
+        if (year < 0 || year > 9999) {
+            throw std::runtime_error("Date out of ISO-8601 range: " + std::to_string(value) + " ms");
+        }
+
+        unsigned seconds = static_cast<unsigned>(millisOfDay / 1000);
+        unsigned millis = static_cast<unsigned>(millisOfDay % 1000);
+        writeDigits(buffer, static_cast<unsigned>(year), 4);
+        buffer[4] = '-';
+        writeDigits(buffer + 5, month, 2);
+        buffer[7] = '-';
+        writeDigits(buffer + 8, day, 2);
+        buffer[10] = 'T';
+        writeDigits(buffer + 11, seconds / 3600, 2);
+        buffer[13] = ':';
+        writeDigits(buffer + 14, seconds / 60 % 60, 2);
+        buffer[16] = ':';
+        writeDigits(buffer + 17, seconds % 60, 2);
+        if (millis == 0) {
+            buffer[19] = 'Z';
+            return 20;
+        }
+        buffer[19] = '.';
+        writeDigits(buffer + 20, millis, 3);
+        buffer[23] = 'Z';
+        return ISO_LENGTH;
+    }
+
+    // Compatibilidad con los llamadores que trabajan con std::tm (UTC)
+    static std::optional<std::tm> parseDate(std::string_view value) {
+        auto millis = parseIso(value);
+        if (!millis) {
+            return std::nullopt;
+        }
+        // División por defecto: -1500 ms es el segundo -2, no el -1
+        std::int64_t floorSeconds = *millis / 1000 - (*millis % 1000 < 0);
+        std::time_t seconds = static_cast<std::time_t>(floorSeconds);
+        std::tm tm = {};
+        gmtime_r(&seconds, &tm);
+        return tm;
+    }
+
+    // Mismo formato que antes, "YYYY-MM-DD HH:MM:SS", con los campos tal cual (sin normalizar)
+    static std::string formatDate(const std::tm& value) {
+        char buffer[64];
+        int length = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d",
+                value.tm_year + 1900, value.tm_mon + 1, value.tm_mday, value.tm_hour, value.tm_min, value.tm_sec);
+        return std::string(buffer, static_cast<std::size_t>(length));
+    }
+};
@@ -5,6 +5,12 @@
 #include <map>
 #include <algorithm>
 #include <stdexcept>
+#include <array>
+#include <string_view>
+#include <thread>
+#include <future>
+#include <charconv>
+#include <type_traits>
 
 class Condition {
 public:
@@ -13,22 +19,249 @@ public:
         // Simula la validación de permisos
         return userId == 1 || objectId % 2 == 0; // Ejemplo: acceso para admin o objetos pares
     }
+
+    // Simula los vínculos de un grupo o dispositivo con los objetos
+    static bool isLinked(long ownerId, long objectId) {
+        return objectId % ownerId == 0;
+    }
+};
+
+// Criterios del listado; 0 = sin filtrar por ese criterio
+struct ObjectFilter {
+    long userId = 0;
+    long groupId = 0;
+    long deviceId = 0;
 };
 
+// Entrada del registro de campos: nombre, comparador tipado y codificación de la clave de paginación
+template <typename T>
+struct FieldEntry {
+    std::string_view name;
+    bool (*less)(const T&, const T&);
+    int (*compareKey)(const T&, std::string_view);
+    std::string (*encodeKey)(const T&);
+    bool (*validKey)(std::string_view);
+};
+
+// Compara dos objetos por el miembro indicado sin crear cadenas temporales
+template <typename T, auto Member>
+bool lessByMember(const T& a, const T& b) {
+    return a.*Member < b.*Member;
+}
+
+// Indica si la clave de un cursor es válida para el tipo del miembro (números completos, sin restos)
+template <typename T, auto Member>
+bool validMemberKey(std::string_view key) {
+    using Value = std::decay_t<decltype(std::declval<const T&>().*Member)>;
+    if constexpr (std::is_arithmetic_v<Value>) {
+        Value parsed{};
+        auto [end, ec] = std::from_chars(key.data(), key.data() + key.size(), parsed);
+        return ec == std::errc() && end == key.data() + key.size();
+    } else {
+        return true;
+    }
+}
+
+// Compara el miembro de un objeto con una clave codificada en un cursor; la clave ya se validó
+// con validMemberKey al decodificar el token
+template <typename T, auto Member>
+int compareMemberToKey(const T& object, std::string_view key) {
+    const auto& value = object.*Member;
+    using Value = std::decay_t<decltype(value)>;
+    if constexpr (std::is_arithmetic_v<Value>) {
+        Value parsed{};
+        std::from_chars(key.data(), key.data() + key.size(), parsed);
+        return value < parsed ? -1 : (parsed < value ? 1 : 0);
+    } else {
+        int order = std::string_view(value).compare(key);
+        return order < 0 ? -1 : (order > 0 ? 1 : 0);
+    }
+}
+
+template <typename T, auto Member>
+std::string encodeMemberKey(const T& object) {
+    const auto& value = object.*Member;
+    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>) {
+        return std::to_string(value);
+    } else {
+        return std::string(value);
+    }
+}
+
+template <typename T, auto Member>
+constexpr FieldEntry<T> fieldEntry(std::string_view name) {
+    return {name, &lessByMember<T, Member>, &compareMemberToKey<T, Member>, &encodeMemberKey<T, Member>,
+            &validMemberKey<T, Member>};
+}
+
+// Resuelve el nombre del campo una sola vez contra el registro del modelo
+template <typename T>
+FieldEntry<T> resolveField(std::string_view field) {
+    for (const auto& entry : T::template fields<T>()) {
+        if (entry.name == field) {
+            return entry;
+        }
+    }
+    throw std::runtime_error("Field not found");
+}
+
+// Posición de paginación: clave del campo de orden e ID del último objeto devuelto
+struct Cursor {
+    long id;
+    std::string key;
+};
+
+// El token de continuación es opaco para el cliente: "<id>:<clave>" en hexadecimal
+std::string encodeToken(const Cursor& cursor) {
+    static const char digits[] = "0123456789abcdef";
+    std::string raw = std::to_string(cursor.id) + ":" + cursor.key;
+    std::string token;
+    token.reserve(raw.size() * 2);
+    for (unsigned char c : raw) {
+        token.push_back(digits[c >> 4]);
+        token.push_back(digits[c & 0x0f]);
+    }
+    return token;
+}
+
+Cursor decodeToken(const std::string& token) {
+    auto nibble = [&token](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        throw std::runtime_error("Invalid continuation token");
+    };
+    if (token.size() % 2 != 0) {
+        throw std::runtime_error("Invalid continuation token");
+    }
+    std::string raw;
+    raw.reserve(token.size() / 2);
+    for (std::size_t i = 0; i < token.size(); i += 2) {
+        raw.push_back(static_cast<char>(nibble(token[i]) << 4 | nibble(token[i + 1])));
+    }
+
+    Cursor cursor{};
+    auto separator = raw.find(':');
+    if (separator == std::string::npos
+            || std::from_chars(raw.data(), raw.data() + separator, cursor.id).ptr != raw.data() + separator) {
+        throw std::runtime_error("Invalid continuation token");
+    }
+    cursor.key = raw.substr(separator + 1);
+    return cursor;
+}
+
+// Página de resultados; nextToken queda vacío en la última página
+template <typename T>
+struct Page {
+    std::vector<T> items;
+    std::string nextToken;
+};
+
+// Ordena por bloques en paralelo y luego mezcla los bloques ordenados
+template <typename T, typename Compare>
+void parallelSort(std::vector<T>& objects, Compare less) {
+    std::size_t chunks = std::max(2u, std::thread::hardware_concurrency());
+    std::size_t chunkSize = (objects.size() + chunks - 1) / chunks;
+
+    std::vector<std::size_t> bounds;
+    for (std::size_t begin = 0; begin < objects.size(); begin += chunkSize) {
+        bounds.push_back(begin);
+    }
+    bounds.push_back(objects.size());
+
+    std::vector<std::future<void>> tasks;
+    for (std::size_t i = 0; i + 1 < bounds.size(); ++i) {
+        tasks.push_back(std::async(std::launch::async, [&, i] {
+            std::sort(objects.begin() + bounds[i], objects.begin() + bounds[i + 1], less);
+        }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+
+    while (bounds.size() > 2) {
+        std::vector<std::size_t> merged;
+        std::size_t i = 0;
+        for (; i + 2 < bounds.size(); i += 2) {
+            std::inplace_merge(objects.begin() + bounds[i], objects.begin() + bounds[i + 1],
+                               objects.begin() + bounds[i + 2], less);
+            merged.push_back(bounds[i]);
+        }
+        if (i + 1 < bounds.size()) {
+            merged.push_back(bounds[i]);
+        }
+        merged.push_back(objects.size());
+        bounds = std::move(merged);
+    }
+}
+
 class Storage {
 public:
+    // A partir de este tamaño se ordena en paralelo
+    static constexpr std::size_t PARALLEL_SORT_THRESHOLD = 50000;
+
     template <typename T>
-    std::vector<T> getObjects(const std::string& sortField) {
-        std::vector<T> objects = {T(1, "Object A"), T(2, "Object B"), T(3, "Object C")};
+    std::vector<T> getObjects(const std::string& sortField, const ObjectFilter& filter = {}) {
+        std::vector<T> objects = loadObjects<T>(filter);
 
         if (!sortField.empty()) {
-            std::sort(objects.begin(), objects.end(), [&](const T& a, const T& b) {
-                return a.getField(sortField) < b.getField(sortField);
-            });
+            auto less = resolveField<T>(sortField).less;
+            if (objects.size() >= PARALLEL_SORT_THRESHOLD) {
+                parallelSort(objects, less);
+            } else {
+                std::sort(objects.begin(), objects.end(), less);
+            }
         }
 
         return objects;
     }
+
+    // Devuelve como máximo "limit" objetos posteriores al cursor "after" (limit 0 = sin límite).
+    // El orden es (sortField, id) para que el cursor sea estable aunque haya claves repetidas.
+    template <typename T>
+    Page<T> getObjectsPage(const std::string& sortField, std::size_t limit, const std::string& after,
+                           const ObjectFilter& filter = {}) {
+        std::vector<T> objects = loadObjects<T>(filter);
+        auto field = resolveField<T>(sortField.empty() ? "id" : sortField);
+        auto less = [&field](const T& a, const T& b) {
+            return field.less(a, b) || (!field.less(b, a) && a.getId() < b.getId());
+        };
+
+        if (!after.empty()) {
+            Cursor cursor = decodeToken(after);
+            if (!field.validKey(cursor.key)) {
+                throw std::runtime_error("Invalid continuation token");
+            }
+            objects.erase(std::remove_if(objects.begin(), objects.end(), [&](const T& object) {
+                int order = field.compareKey(object, cursor.key);
+                return order < 0 || (order == 0 && object.getId() <= cursor.id);
+            }), objects.end());
+        }
+
+        Page<T> page;
+        if (limit > 0 && objects.size() > limit) {
+            // Solo se ordenan los primeros "limit" elementos
+            std::partial_sort(objects.begin(), objects.begin() + limit, objects.end(), less);
+            objects.erase(objects.begin() + limit, objects.end());
+            page.nextToken = encodeToken({objects.back().getId(), field.encodeKey(objects.back())});
+        } else {
+            std::sort(objects.begin(), objects.end(), less);
+        }
+        page.items = std::move(objects);
+        return page;
+    }
+
+private:
+    // Solo los objetos visibles para filter.userId y vinculados al grupo y al dispositivo indicados
+    template <typename T>
+    std::vector<T> loadObjects(const ObjectFilter& filter) {
+        std::vector<T> objects = {T(1, "Object A"), T(2, "Object B"), T(3, "Object C")};
+        objects.erase(std::remove_if(objects.begin(), objects.end(), [&filter](const T& object) {
+            return (filter.userId > 0 && !Condition::checkPermission(filter.userId, object.getId()))
+                    || (filter.groupId > 0 && !Condition::isLinked(filter.groupId, object.getId()))
+                    || (filter.deviceId > 0 && !Condition::isLinked(filter.deviceId, object.getId()));
+        }), objects.end());
+        return objects;
+    }
 };
 
 class BaseObject {
@@ -43,6 +276,15 @@ public:
         return id;
     }
 
+    // Registro de campos ordenables del modelo
+    template <typename T>
+    static constexpr std::array<FieldEntry<T>, 2> fields() {
+        return {{
+            fieldEntry<T, &BaseObject::id>("id"),
+            fieldEntry<T, &BaseObject::name>("name"),
+        }};
+    }
+
     std::string getField(const std::string& field) const {
         if (field == "name") {
             return name;
@@ -59,15 +301,34 @@ private:
     long userId;
 
 public:
-    ExtendedObjectResource(long userId, const std::string& sortField) : userId(userId), sortField(sortField) {}
+    ExtendedObjectResource(long userId, const std::string& sortField) : sortField(sortField), userId(userId) {}
 
     std::vector<T> get(bool all, long filterUserId, long groupId, long deviceId) {
-        std::vector<T> results;
+        return storage.getObjects<T>(sortField, checkAccess(all, filterUserId, groupId, deviceId));
+    }
 
+    // Variante paginada por cursor: "after" es el token devuelto por la página anterior
+    Page<T> get(bool all, long filterUserId, long groupId, long deviceId, std::size_t limit, const std::string& after) {
+        return storage.getObjectsPage<T>(sortField, limit, after, checkAccess(all, filterUserId, groupId, deviceId));
+    }
+
+private:
+    // Devuelve los criterios del listado; sin "all" ni usuario explícito se listan los del propio usuario
+    ObjectFilter checkAccess(bool all, long filterUserId, long groupId, long deviceId) {
+        ObjectFilter filter{0, groupId, deviceId};
         if (all) {
             if (!Condition::checkPermission(userId, 0)) {
                 throw std::runtime_error("Admin permissions required for 'all' access");
             }
+        } else {
+            filter.userId = filterUserId > 0 ? filterUserId : userId;
+        }
+
+        // Filtrar por usuario
+        if (filterUserId > 0) {
+            if (!Condition::checkPermission(userId, filterUserId)) {
+                throw std::runtime_error("Permission denied for user ID: " + std::to_string(filterUserId));
+            }
         }
 
         // Filtrar por grupo
@@ -83,9 +344,7 @@ public:
                 throw std::runtime_error("Permission denied for device ID: " + std::to_string(deviceId));
             }
         }
-
-        results = storage.getObjects<T>(sortField);
-        return results;
+        return filter;
     }
 };
 
@@ -103,6 +362,20 @@ int main() {
         for (const auto& obj : results) {
             std::cout << "ID: " << obj.getId() << ", Name: " << obj.getField("name") << std::endl;
         }
+
+        // Recorrer el listado por páginas de 2 elementos
+        std::string token;
+        do {
+            auto page = resource.get(true, 0, 0, 0, 2, token);
+            for (const auto& obj : page.items) {
+                std::cout << "Page item ID: " << obj.getId() << ", Name: " << obj.getField("name") << std::endl;
+            }
+            token = page.nextToken;
+        } while (!token.empty());
+
+        // Listado paginado de los objetos visibles para el usuario 2
+        auto filtered = resource.get(false, 2, 0, 0, 10, "");
+        std::cout << "Objects visible to user 2: " << filtered.items.size() << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
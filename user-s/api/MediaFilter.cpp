@@ -4,7 +4,18 @@
 #include <map>
 #include <memory>
 #include <stdexcept>
-#include <sstream>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 
@@ -21,16 +32,40 @@ public:
     Device(long id, const std::string& uniqueId) : id(id), uniqueId(uniqueId) {}
 
     long getId() const { return id; }
-    std::string getUniqueId() const { return uniqueId; }
+    const std::string& getUniqueId() const { return uniqueId; }
 };
 
 class Storage {
+private:
+    std::vector<std::shared_ptr<Device>> devices;
+    // Índice uniqueId -> dispositivo; las claves apuntan al uniqueId de cada Device, que vive en el heap
+    std::unordered_map<std::string_view, std::shared_ptr<Device>> uniqueIdIndex;
+
 public:
+    Storage() {
+        addDevice(std::make_shared<Device>(1, "validDevice"));
+    }
+
+    void addDevice(std::shared_ptr<Device> device) {
+        uniqueIdIndex.emplace(device->getUniqueId(), device);
+        devices.push_back(std::move(device));
+    }
+
     std::shared_ptr<Device> getObject(const std::string& uniqueId) {
-        if (uniqueId == "validDevice") {
-            return std::make_shared<Device>(1, uniqueId);
+        auto it = uniqueIdIndex.find(uniqueId);
+        if (it == uniqueIdIndex.end()) {
+            throw std::runtime_error("Device not found");
         }
-        throw std::runtime_error("Device not found");
+        return it->second;
+    }
+
+    // Búsqueda sin excepciones ni copias de la clave, para el camino caliente de los filtros
+    std::optional<long> findDeviceId(std::string_view uniqueId) const {
+        auto it = uniqueIdIndex.find(uniqueId);
+        if (it == uniqueIdIndex.end()) {
+            return std::nullopt;
+        }
+        return it->second->getId();
     }
 };
 
@@ -43,56 +78,515 @@ public:
 
 class PermissionsService {
 public:
+    bool hasPermission(long userId, long /* deviceId */) const noexcept {
+        return userId == 1;
+    }
+
     void checkPermission(long userId, long deviceId) {
-        if (userId != 1) {
+        if (!hasPermission(userId, deviceId)) {
             throw std::runtime_error("Permission denied for user ID: " + std::to_string(userId));
         }
     }
 };
 
-class MediaFilter {
+// Recorre los segmentos no vacíos de una ruta sin copiarlos; ignora la query string
+class PathTokenizer {
 private:
-    Storage storage;
-    StatisticsManager statisticsManager;
-    PermissionsService permissionsService;
+    std::string_view path;
+    std::string_view remaining;
 
 public:
-    void doFilter(http::request<http::string_body>& req, http::response<http::string_body>& res, long userId) {
-        try {
-            if (userId == 0) {
-                res.result(http::status::unauthorized);
-                res.body() = "Unauthorized";
-                return;
+    explicit PathTokenizer(std::string_view target) : path(target.substr(0, target.find('?'))), remaining(path) {}
+
+    // Resto de la ruta a partir de un segmento devuelto por next()
+    std::string_view from(std::string_view segment) const {
+        return path.substr(static_cast<std::size_t>(segment.data() - path.data()));
+    }
+
+    std::optional<std::string_view> next() {
+        while (!remaining.empty()) {
+            auto end = remaining.find('/');
+            auto segment = remaining.substr(0, end);
+            remaining.remove_prefix(end == std::string_view::npos ? remaining.size() : end + 1);
+            if (!segment.empty()) {
+                return segment;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+// Descriptor de fichero que se cierra al salir de ámbito
+class FileDescriptor {
+private:
+    int fd;
+
+public:
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    int get() const { return fd; }
+    bool valid() const { return fd >= 0; }
+};
+
+// Sirve ficheros del directorio de medios: sendfile para los grandes y pread a un buffer para los
+// pequeños. Responde 304 si el cliente ya tiene la versión actual (ETag/If-None-Match o
+// Last-Modified/If-Modified-Since) y 206 para peticiones Range de un tramo. Los envíos son
+// bloqueantes con esperas acotadas: serve() debe ejecutarse fuera del io_context (ver MediaFilter).
+class MediaServer {
+private:
+    static constexpr off_t SMALL_FILE_LIMIT = 64 * 1024;
+    static constexpr std::size_t SENDFILE_CHUNK = 1 << 20;
+    // Tiempo máximo esperando a que un cliente lento vuelva a aceptar datos
+    static constexpr int SEND_TIMEOUT_MILLIS = 30000;
+
+    // Nombres fijos en inglés: strftime/strptime con %a y %b dependen del locale
+    static constexpr const char* DAY_NAMES[7] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static constexpr const char* MONTH_NAMES[12] = {
+            "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    struct ByteRange {
+        off_t first;
+        off_t last;
+    };
+
+    std::string root;
+
+    static std::string_view headerValue(const http::request<http::string_body>& req, http::field field) {
+        auto value = req[field];
+        return std::string_view(value.data(), value.size());
+    }
+
+    // ETag fuerte derivado de la fecha de modificación y el tamaño, como hacen nginx y Apache
+    static std::string makeEtag(const struct stat& info) {
+        char buffer[64];
+        int length = std::snprintf(buffer, sizeof(buffer), "\"%llx-%llx\"",
+                static_cast<unsigned long long>(info.st_mtime), static_cast<unsigned long long>(info.st_size));
+        return std::string(buffer, static_cast<std::size_t>(length));
+    }
+
+    // Formato IMF-fixdate de RFC 7231: "Sun, 06 Nov 1994 08:49:37 GMT"
+    static std::string formatHttpDate(std::time_t time) {
+        std::tm tm{};
+        gmtime_r(&time, &tm);
+        char buffer[40];
+        int length = std::snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                DAY_NAMES[tm.tm_wday], tm.tm_mday, MONTH_NAMES[tm.tm_mon], tm.tm_year + 1900,
+                tm.tm_hour, tm.tm_min, tm.tm_sec);
+        return std::string(buffer, static_cast<std::size_t>(length));
+    }
+
+    static bool parseNumber(std::string_view text, int& value) {
+        auto end = text.data() + text.size();
+        auto result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    static std::optional<std::time_t> parseHttpDate(std::string_view value) {
+        // "Sun, 06 Nov 1994 08:49:37 GMT"
+        if (value.size() != 29 || value.substr(3, 2) != ", " || value[7] != ' ' || value[11] != ' '
+                || value[16] != ' ' || value[19] != ':' || value[22] != ':' || value.substr(25) != " GMT") {
+            return std::nullopt;
+        }
+        bool knownDay = false;
+        for (const char* day : DAY_NAMES) {
+            knownDay = knownDay || value.substr(0, 3) == day;
+        }
+        int month = 0;
+        while (month < 12 && value.substr(8, 3) != MONTH_NAMES[month]) {
+            month++;
+        }
+        std::tm tm{};
+        if (!knownDay || month == 12
+                || !parseNumber(value.substr(5, 2), tm.tm_mday) || !parseNumber(value.substr(12, 4), tm.tm_year)
+                || !parseNumber(value.substr(17, 2), tm.tm_hour) || !parseNumber(value.substr(20, 2), tm.tm_min)
+                || !parseNumber(value.substr(23, 2), tm.tm_sec)) {
+            return std::nullopt;
+        }
+        tm.tm_mon = month;
+        tm.tm_year -= 1900;
+        return timegm(&tm);
+    }
+
+    // If-None-Match admite una lista separada por comas, "*" y etiquetas débiles (W/)
+    static bool matchesEtag(std::string_view header, std::string_view etag) {
+        while (!header.empty()) {
+            auto comma = header.find(',');
+            auto candidate = header.substr(0, comma);
+            header.remove_prefix(comma == std::string_view::npos ? header.size() : comma + 1);
+            while (!candidate.empty() && candidate.front() == ' ') candidate.remove_prefix(1);
+            while (!candidate.empty() && candidate.back() == ' ') candidate.remove_suffix(1);
+            if (candidate.substr(0, 2) == "W/") candidate.remove_prefix(2);
+            if (candidate == "*" || candidate == etag) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool notModified(const http::request<http::string_body>& req, const std::string& etag, std::time_t modified) {
+        auto ifNoneMatch = headerValue(req, http::field::if_none_match);
+        if (!ifNoneMatch.empty()) {
+            return matchesEtag(ifNoneMatch, etag);
+        }
+        auto ifModifiedSince = headerValue(req, http::field::if_modified_since);
+        if (!ifModifiedSince.empty()) {
+            auto since = parseHttpDate(ifModifiedSince);
+            return since && modified <= *since;
+        }
+        return false;
+    }
+
+    static bool parseNumber(std::string_view text, off_t& value) {
+        long long number = 0;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size() || number < 0) {
+            return false;
+        }
+        value = static_cast<off_t>(number);
+        return true;
+    }
+
+    // Solo se admite un tramo ("bytes=a-b", "bytes=a-" o "bytes=-n"); el resto se sirve completo.
+    // Devuelve false si el tramo no es satisfacible.
+    static bool parseRange(std::string_view header, off_t size, std::optional<ByteRange>& range) {
+        constexpr std::string_view unit = "bytes=";
+        if (header.substr(0, unit.size()) != unit || header.find(',') != std::string_view::npos) {
+            return true;
+        }
+        header.remove_prefix(unit.size());
+        auto dash = header.find('-');
+        if (dash == std::string_view::npos) {
+            return true;
+        }
+        auto firstText = header.substr(0, dash);
+        auto lastText = header.substr(dash + 1);
+        off_t first = 0;
+        off_t last = size - 1;
+        if (firstText.empty()) {
+            off_t suffix = 0;
+            if (!parseNumber(lastText, suffix)) {
+                return true;
+            }
+            // Un fichero vacío no tiene ningún sufijo que servir
+            if (suffix == 0 || size == 0) {
+                return false;
+            }
+            first = suffix >= size ? 0 : size - suffix;
+        } else {
+            if (!parseNumber(firstText, first) || (!lastText.empty() && !parseNumber(lastText, last))) {
+                return true;
+            }
+            if (!lastText.empty() && last < first) {
+                return true;
+            }
+            if (first >= size) {
+                return false;
+            }
+            if (last >= size) {
+                last = size - 1;
+            }
+        }
+        range = ByteRange{first, last};
+        return true;
+    }
+
+    static const char* contentType(std::string_view path) {
+        auto dot = path.rfind('.');
+        auto extension = dot == std::string_view::npos ? std::string_view() : path.substr(dot + 1);
+        if (extension == "jpg" || extension == "jpeg") return "image/jpeg";
+        if (extension == "png") return "image/png";
+        if (extension == "gif") return "image/gif";
+        if (extension == "webp") return "image/webp";
+        if (extension == "svg") return "image/svg+xml";
+        if (extension == "mp4") return "video/mp4";
+        return "application/octet-stream";
+    }
+
+    // Rechaza rutas vacías y segmentos que puedan salir del directorio de medios
+    static bool safePath(std::string_view path) {
+        if (path.empty() || path.find('\0') != std::string_view::npos) {
+            return false;
+        }
+        PathTokenizer tokenizer(path);
+        while (auto segment = tokenizer.next()) {
+            if (*segment == "." || *segment == "..") {
+                return false;
             }
+        }
+        return true;
+    }
 
-            statisticsManager.registerRequest(userId);
+    // Espera a que el socket acepte datos; false si el cliente no los acepta en SEND_TIMEOUT_MILLIS
+    static bool waitWritable(int socketFd) {
+        pollfd descriptor{socketFd, POLLOUT, 0};
+        int ready;
+        do {
+            ready = ::poll(&descriptor, 1, SEND_TIMEOUT_MILLIS);
+        } while (ready < 0 && errno == EINTR);
+        return ready > 0;
+    }
 
-            std::string path = req.target().to_string();
-            std::istringstream pathStream(path);
-            std::vector<std::string> parts;
-            std::string segment;
+    static bool sendAll(int socketFd, const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t sent = ::send(socketFd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent > 0) {
+                data += sent;
+                size -= static_cast<std::size_t>(sent);
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && errno == EAGAIN) {
+                if (!waitWritable(socketFd)) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
 
-            while (std::getline(pathStream, segment, '/')) {
-                if (!segment.empty()) {
-                    parts.push_back(segment);
+    // Serializa la respuesta a texto; con headerOnly solo la cabecera, porque el cuerpo va aparte
+    template <typename Body>
+    static std::string serialize(http::response<Body>& res, bool headerOnly) {
+        std::string out;
+        http::response_serializer<Body> serializer{res};
+        serializer.split(headerOnly);
+        beast::error_code ec;
+        while (!ec && !(headerOnly ? serializer.is_header_done() : serializer.is_done())) {
+            serializer.next(ec, [&](beast::error_code&, const auto& buffers) {
+                out += beast::buffers_to_string(buffers);
+                serializer.consume(beast::buffer_bytes(buffers));
+            });
+        }
+        return out;
+    }
+
+    static bool sendHeader(int socketFd, http::response<http::empty_body>& res) {
+        std::string header = serialize(res, true);
+        return sendAll(socketFd, header.data(), header.size());
+    }
+
+    static void writeStatus(int socketFd, http::status status, std::string_view message) {
+        http::response<http::string_body> res{status, 11};
+        res.set(http::field::content_type, "text/plain");
+        res.body().assign(message.data(), message.size());
+        res.prepare_payload();
+        send(socketFd, res);
+    }
+
+    // Envía "length" bytes del fichero desde "offset" con sendfile, esperando si el socket no acepta más.
+    // Devuelve false si falla, si el cliente no acepta datos en SEND_TIMEOUT_MILLIS o si el fichero
+    // se ha truncado (sendfile devuelve 0 antes de tiempo); la respuesta queda incompleta.
+    static bool sendFile(int socketFd, int fileFd, off_t offset, off_t length) {
+        while (length > 0) {
+            ssize_t sent = ::sendfile(socketFd, fileFd, &offset,
+                    static_cast<std::size_t>(std::min<off_t>(length, SENDFILE_CHUNK)));
+            if (sent > 0) {
+                length -= sent;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && errno == EAGAIN) {
+                if (!waitWritable(socketFd)) {
+                    return false;
                 }
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Ficheros pequeños: una copia con pread en vez de mmap, que con el fichero truncado después
+    // de fstat provocaría SIGBUS; aquí el truncado se ve como una lectura corta
+    static bool sendSmallFile(int socketFd, int fileFd, off_t offset, off_t length) {
+        char buffer[SMALL_FILE_LIMIT];
+        std::size_t total = 0;
+        while (total < static_cast<std::size_t>(length)) {
+            ssize_t received = ::pread(fileFd, buffer + total, static_cast<std::size_t>(length) - total,
+                    offset + static_cast<off_t>(total));
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
             }
+            total += static_cast<std::size_t>(received);
+        }
+        return sendAll(socketFd, buffer, total);
+    }
+
+public:
+    explicit MediaServer(std::string root) : root(std::move(root)) {}
+
+    // Envía una respuesta completa con las mismas esperas acotadas que los ficheros
+    static bool send(int socketFd, http::response<http::string_body>& res) {
+        std::string message = serialize(res, false);
+        return sendAll(socketFd, message.data(), message.size());
+    }
+
+    // Sirve el fichero relativo al directorio de medios (<uniqueId>/<fichero>) por el socket.
+    // Bloquea el hilo que llama hasta terminar o agotar SEND_TIMEOUT_MILLIS.
+    void serve(const http::request<http::string_body>& req, std::string_view relativePath, net::ip::tcp::socket& socket) {
+        // Sin bloqueo a nivel de descriptor, para que sendfile y send devuelvan EAGAIN y la espera
+        // pase por poll con límite
+        beast::error_code ignored;
+        socket.non_blocking(true, ignored);
+        int socketFd = socket.native_handle();
+        if (!safePath(relativePath)) {
+            writeStatus(socketFd, http::status::not_found, "Not found");
+            return;
+        }
 
-            if (parts.size() >= 2) {
-                auto device = storage.getObject(parts[1]);
-                permissionsService.checkPermission(userId, device->getId());
-                res.result(http::status::ok);
-                res.body() = "Access granted";
+        std::string path = root;
+        path += '/';
+        path.append(relativePath.data(), relativePath.size());
+        FileDescriptor file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        struct stat info{};
+        if (!file.valid() || ::fstat(file.get(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            writeStatus(socketFd, http::status::not_found, "Not found");
+            return;
+        }
+
+        std::string etag = makeEtag(info);
+        http::response<http::empty_body> res{http::status::ok, req.version()};
+        res.set(http::field::etag, etag);
+        res.set(http::field::last_modified, formatHttpDate(info.st_mtime));
+        res.set(http::field::cache_control, "private, no-cache");
+        res.set(http::field::accept_ranges, "bytes");
+        res.keep_alive(req.keep_alive());
+
+        if (notModified(req, etag, info.st_mtime)) {
+            res.result(http::status::not_modified);
+            sendHeader(socketFd, res);
+            return;
+        }
+
+        off_t size = info.st_size;
+        std::optional<ByteRange> range;
+        auto rangeHeader = headerValue(req, http::field::range);
+        auto ifRange = headerValue(req, http::field::if_range);
+        if (!rangeHeader.empty() && (ifRange.empty() || ifRange == etag)) {
+            if (!parseRange(rangeHeader, size, range)) {
+                res.result(http::status::range_not_satisfiable);
+                res.set(http::field::content_range, "bytes */" + std::to_string(size));
+                res.content_length(0);
+                sendHeader(socketFd, res);
                 return;
             }
+        }
 
+        off_t offset = range ? range->first : 0;
+        off_t length = range ? range->last - range->first + 1 : size;
+        if (range) {
+            res.result(http::status::partial_content);
+            res.set(http::field::content_range, "bytes " + std::to_string(range->first) + "-"
+                    + std::to_string(range->last) + "/" + std::to_string(size));
+        }
+        res.set(http::field::content_type, contentType(relativePath));
+        res.content_length(static_cast<std::uint64_t>(length));
+
+        bool sent = sendHeader(socketFd, res);
+        if (sent && req.method() != http::verb::head && length > 0) {
+            sent = size <= SMALL_FILE_LIMIT
+                    ? sendSmallFile(socketFd, file.get(), offset, length)
+                    : sendFile(socketFd, file.get(), offset, length);
+        }
+        if (!sent) {
+            // Ya se anunció Content-Length: cerrar es la única forma de que el cliente note el corte
+            std::cerr << "Media transfer aborted: " << path << std::endl;
+            socket.shutdown(net::ip::tcp::socket::shutdown_both, ignored);
+            socket.close(ignored);
+        }
+    }
+};
+
+class MediaFilter {
+private:
+    Storage storage;
+    StatisticsManager statisticsManager;
+    PermissionsService permissionsService;
+    MediaServer mediaServer;
+    // Hilos dedicados a los envíos bloqueantes de MediaServer; un cliente lento ocupa uno de
+    // ellos y nunca el hilo del io_context
+    net::thread_pool transfers;
+
+    static void respond(http::response<http::string_body>& res, http::status status, std::string_view message) {
+        res.result(status);
+        res.body().assign(message.data(), message.size());
+    }
+
+    // Ruta esperada: /media/<uniqueId>/...; devuelve la ruta a partir de <uniqueId> si el usuario
+    // tiene acceso o rellena la respuesta de error. Los fallos se resuelven sin excepciones.
+    std::optional<std::string_view> authorize(std::string_view target, http::response<http::string_body>& res, long userId) {
+        if (userId == 0) {
+            respond(res, http::status::unauthorized, "Unauthorized");
+            return std::nullopt;
+        }
+
+        statisticsManager.registerRequest(userId);
+
+        PathTokenizer tokenizer(target);
+        auto prefix = tokenizer.next();
+        auto uniqueId = prefix ? tokenizer.next() : std::nullopt;
+        if (!uniqueId) {
+            respond(res, http::status::forbidden, "Forbidden: Invalid path");
+            return std::nullopt;
+        }
+
+        auto deviceId = storage.findDeviceId(*uniqueId);
+        if (!deviceId) {
+            respond(res, http::status::forbidden, "Forbidden: Device not found");
+            return std::nullopt;
+        }
+
+        if (!permissionsService.hasPermission(userId, *deviceId)) {
             res.result(http::status::forbidden);
-            res.body() = "Forbidden: Invalid path";
-        } catch (const std::exception& e) {
-            res.result(http::status::forbidden);
-            res.body() = "Forbidden: " + std::string(e.what());
+            res.body() = "Forbidden: Permission denied for user ID: " + std::to_string(userId);
+            return std::nullopt;
+        }
+
+        return tokenizer.from(*uniqueId);
+    }
+
+public:
+    explicit MediaFilter(std::string mediaRoot = "media", std::size_t transferThreads = 4)
+        : mediaServer(std::move(mediaRoot)), transfers(transferThreads) {}
+
+    // Espera a que terminen los envíos en curso
+    void join() {
+        transfers.join();
+    }
+
+    void doFilter(http::request<http::string_body>& req, http::response<http::string_body>& res, long userId) {
+        auto target = req.target();
+        if (authorize(std::string_view(target.data(), target.size()), res, userId)) {
+            respond(res, http::status::ok, "Access granted");
         }
     }
+
+    // Autoriza la petición y, si procede, sirve el fichero por el socket. Todo se ejecuta en el pool
+    // de transferencias: el hilo del io_context que llama vuelve de inmediato. El socket no debe
+    // usarse desde otro sitio hasta que termine el envío.
+    void handle(http::request<http::string_body> req, std::shared_ptr<net::ip::tcp::socket> socket, long userId) {
+        net::post(transfers, [this, req = std::move(req), socket = std::move(socket), userId] {
+            http::response<http::string_body> res{http::status::ok, req.version()};
+            auto target = req.target();
+            auto relativePath = authorize(std::string_view(target.data(), target.size()), res, userId);
+            if (!relativePath) {
+                res.prepare_payload();
+                MediaServer::send(socket->native_handle(), res);
+                return;
+            }
+            mediaServer.serve(req, *relativePath, *socket);
+        });
+    }
 };
 
 int main() {
@@ -109,6 +603,28 @@ int main() {
         filter.doFilter(req, res, userId);
 
         std::cout << "Response: " << res.result_int() << " - " << res.body() << std::endl;
+
+        // Descarga de un fichero por una conexión local; el envío corre en el pool de transferencias
+        ::mkdir("media", 0755);
+        ::mkdir("media/validDevice", 0755);
+        std::FILE* sample = std::fopen("media/validDevice/photo.jpg", "wb");
+        if (sample) {
+            std::fputs("sample image", sample);
+            std::fclose(sample);
+        }
+        net::ip::tcp::acceptor acceptor(ioc, net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+        net::ip::tcp::socket client(ioc);
+        client.connect(acceptor.local_endpoint());
+        auto server = std::make_shared<net::ip::tcp::socket>(acceptor.accept());
+
+        http::request<http::string_body> download{http::verb::get, "/media/validDevice/photo.jpg", 11};
+        filter.handle(std::move(download), server, userId);
+
+        beast::flat_buffer buffer;
+        http::response<http::string_body> file;
+        http::read(client, buffer, file);
+        std::cout << "Download: " << file.result_int() << " - " << file.body() << std::endl;
+        filter.join();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Arena por petición: lo que reserva una petición se libera de una vez al terminarla. Los primeros
+// bytes salen de un buffer en la pila y el resto de un pool compartido que se reutiliza entre
+// peticiones sin volver al allocator global. El pool es sincronizado, así que la arena puede
+// destruirse en un hilo distinto del que la creó (p. ej. al terminar una petición asíncrona).
+class RequestArena {
+private:
+    static constexpr std::size_t INLINE_SIZE = 4096;
+
+    alignas(std::max_align_t) std::byte initial[INLINE_SIZE];
+    std::pmr::monotonic_buffer_resource resource;
+
+    // Nunca se destruye, para que sobreviva a arenas que terminan durante la salida del proceso
+    static std::pmr::memory_resource* sharedPool() {
+        static auto* pool = new std::pmr::synchronized_pool_resource();
+        return pool;
+    }
+
+public:
+    RequestArena() : resource(initial, INLINE_SIZE, sharedPool()) {}
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* get() { return &resource; }
+};
@@ -2,7 +2,9 @@
 #include <stdexcept>
 #include <string>
 #include <sstream>
+#include <array>
 #include <boost/beast/http.hpp>
+#include "ApiError.h"
 
 namespace http = boost::beast::http;
 
@@ -32,7 +34,37 @@ public:
 };
 
 class ResourceErrorHandler {
+private:
+    static constexpr std::size_t ERROR_CODE_COUNT = static_cast<std::size_t>(ErrorCode::Count);
+
+    // Una respuesta ya preparada por código de error; el cuerpo no incluye detalles del objeto
+    std::array<http::response<http::string_body>, ERROR_CODE_COUNT> prebuilt;
+
+    static http::response<http::string_body> makeResponse(http::status status, const std::string& body) {
+        http::response<http::string_body> response(status, 11);
+        response.set(http::field::content_type, "text/plain");
+        response.body() = body;
+        response.prepare_payload();
+        return response;
+    }
+
 public:
+    ResourceErrorHandler() {
+        prebuilt[static_cast<std::size_t>(ErrorCode::BadRequest)] = makeResponse(http::status::bad_request, "Bad request");
+        prebuilt[static_cast<std::size_t>(ErrorCode::Unauthorized)] = makeResponse(http::status::unauthorized, "Unauthorized");
+        prebuilt[static_cast<std::size_t>(ErrorCode::Forbidden)] = makeResponse(http::status::forbidden, "Access denied");
+        prebuilt[static_cast<std::size_t>(ErrorCode::AdminRequired)] = makeResponse(http::status::forbidden, "Access denied");
+        prebuilt[static_cast<std::size_t>(ErrorCode::UserAccessDenied)] = makeResponse(http::status::forbidden, "Access denied");
+        prebuilt[static_cast<std::size_t>(ErrorCode::NotFound)] = makeResponse(http::status::not_found, "Not found");
+        prebuilt[static_cast<std::size_t>(ErrorCode::UserNotFound)] = makeResponse(http::status::not_found, "Not found");
+    }
+
+    // Camino habitual: errores devueltos como ApiError, sin excepciones ni construcción del cuerpo
+    const http::response<http::string_body>& toResponse(const ApiError& error) const {
+        return prebuilt[static_cast<std::size_t>(error.code)];
+    }
+
+    // Excepciones inesperadas que siguen llegando desde fuera de los recursos
     http::response<http::string_body> toResponse(const std::exception& e) {
         if (const auto* webException = dynamic_cast<const WebApplicationException*>(&e)) {
             auto response = webException->getResponse();
@@ -51,6 +83,9 @@ public:
 int main() {
     ResourceErrorHandler errorHandler;
 
+    const auto& denied = errorHandler.toResponse(ApiError{ErrorCode::Forbidden, 100});
+    std::cout << "Response: " << denied.result_int() << " - " << denied.body() << std::endl;
+
     try {
         throw WebApplicationException("Not Found", http::status::not_found);
     } catch (const std::exception& e) {
@@ -3,6 +3,20 @@
 #include <map>
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 class Logger {
 public:
@@ -24,37 +38,467 @@ public:
     }
 };
 
+enum class AttributeType {
+    String,
+    Number,
+    Boolean
+};
+
+// Atributo calculado con campos tipados; los textos cortos caben en el buffer interno de std::string
+struct Attribute {
+    long id;
+    AttributeType type;
+    std::string description;
+    std::string attribute;
+    std::string expression;
+};
+
+// Almacenamiento plano: registros contiguos ordenados por ID, búsqueda binaria y sin nodos por campo.
+// get() devuelve una copia, así que nada de lo que sale queda ligado a modificaciones posteriores.
+template <typename T>
 class Storage {
 private:
-    std::map<long, std::map<std::string, std::string>> database;
+    std::vector<T> records;
 
-public:
-    void add(long id, const std::map<std::string, std::string>& attributes) {
-        database[id] = attributes;
+    typename std::vector<T>::iterator find(long id) {
+        return std::lower_bound(records.begin(), records.end(), id,
+                [](const T& record, long key) { return record.id < key; });
     }
 
-    std::map<std::string, std::string> get(long id) {
-        if (database.find(id) != database.end()) {
-            return database[id];
+    typename std::vector<T>::const_iterator find(long id) const {
+        return std::lower_bound(records.begin(), records.end(), id,
+                [](const T& record, long key) { return record.id < key; });
+    }
+
+public:
+    // Los IDs nuevos suelen ser crecientes: se añaden al final en O(1) amortizado; solo un ID
+    // intermedio paga la inserción con desplazamiento
+    void add(T record) {
+        if (records.empty() || records.back().id < record.id) {
+            records.push_back(std::move(record));
+            return;
+        }
+        auto it = find(record.id);
+        if (it != records.end() && it->id == record.id) {
+            *it = std::move(record);
         } else {
+            records.insert(it, std::move(record));
+        }
+    }
+
+    T get(long id) const {
+        auto it = find(id);
+        if (it == records.end() || it->id != id) {
             throw std::runtime_error("Resource not found with ID: " + std::to_string(id));
         }
+        return *it;
     }
 
-    void update(long id, const std::map<std::string, std::string>& attributes) {
-        if (database.find(id) != database.end()) {
-            database[id] = attributes;
-        } else {
-            throw std::runtime_error("Cannot update non-existing resource with ID: " + std::to_string(id));
+    // Como get(), pero sin excepción para los caminos calientes
+    std::optional<T> tryGet(long id) const {
+        auto it = find(id);
+        if (it == records.end() || it->id != id) {
+            return std::nullopt;
         }
+        return *it;
+    }
+
+    void update(T record) {
+        auto it = find(record.id);
+        if (it == records.end() || it->id != record.id) {
+            throw std::runtime_error("Cannot update non-existing resource with ID: " + std::to_string(record.id));
+        }
+        *it = std::move(record);
     }
 
     void remove(long id) {
-        if (database.find(id) != database.end()) {
-            database.erase(id);
-        } else {
+        auto it = find(id);
+        if (it == records.end() || it->id != id) {
             throw std::runtime_error("Cannot remove non-existing resource with ID: " + std::to_string(id));
         }
+        records.erase(it);
+    }
+};
+
+// Posición mínima contra la que se evalúan los atributos calculados
+struct Position {
+    double latitude = 0;
+    double longitude = 0;
+    double altitude = 0;
+    double speed = 0;
+    double course = 0;
+    bool valid = false;
+    std::vector<std::pair<std::string, double>> attributes;
+
+    const double* findAttribute(std::string_view key) const {
+        for (const auto& [name, value] : attributes) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Expresión de atributo compilada una vez a bytecode para una máquina de pila. Admite números,
+// true/false, campos de la posición, atributos de la posición por nombre, aritmética, comparaciones,
+// !, && y || con cortocircuito, y el ternario. Evaluar no reserva memoria: la pila tiene tamaño fijo
+// y los nombres de atributo se resuelven contra vistas guardadas al compilar. Un atributo ausente
+// vale NaN, que es falso en las condiciones.
+class CompiledExpression {
+public:
+    static constexpr std::size_t MAX_STACK = 32;
+    // Niveles de recursión del parser (un paréntesis cuenta dos: ternario y unario), para que
+    // "((((..." o "----..." no agoten la pila del hilo
+    static constexpr std::size_t MAX_NESTING = 256;
+
+private:
+    enum class Op : std::uint8_t {
+        Constant, Field, Attribute,
+        Add, Subtract, Multiply, Divide, Modulo, Negate, Not,
+        Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,
+        Jump, JumpIfFalse, JumpIfFalseOrPop, JumpIfTrueOrPop, ToBoolean
+    };
+
+    enum Field : std::uint32_t { Latitude, Longitude, Altitude, Speed, Course, Valid };
+
+    struct Instruction {
+        Op op;
+        std::uint32_t operand = 0;
+        double constant = 0;
+    };
+
+    std::vector<Instruction> code;
+    std::vector<std::string> attributeNames;
+
+    // Parser descendente recursivo que emite el bytecode directamente
+    class Compiler {
+    private:
+        CompiledExpression& target;
+        std::string_view source;
+        std::size_t position = 0;
+        std::size_t depth = 0;
+        std::size_t maxDepth = 0;
+        std::size_t nesting = 0;
+
+        [[noreturn]] void fail(const std::string& message) const {
+            throw std::invalid_argument(message + " at position " + std::to_string(position)
+                    + " in expression: " + std::string(source));
+        }
+
+        // Cuenta un nivel de recursión mientras vive
+        class Nested {
+        private:
+            Compiler& compiler;
+
+        public:
+            explicit Nested(Compiler& compiler) : compiler(compiler) {
+                if (++compiler.nesting > MAX_NESTING) {
+                    compiler.fail("Expression too deeply nested");
+                }
+            }
+
+            ~Nested() {
+                --compiler.nesting;
+            }
+
+            Nested(const Nested&) = delete;
+            Nested& operator=(const Nested&) = delete;
+        };
+
+        void skipSpaces() {
+            while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position]))) {
+                ++position;
+            }
+        }
+
+        bool accept(std::string_view token) {
+            skipSpaces();
+            if (source.substr(position, token.size()) == token) {
+                position += token.size();
+                return true;
+            }
+            return false;
+        }
+
+        void expect(std::string_view token) {
+            if (!accept(token)) {
+                fail("Expected '" + std::string(token) + "'");
+            }
+        }
+
+        // Ajusta la profundidad de pila estimada tras emitir cada instrucción
+        std::size_t emit(Op op, int stackEffect, std::uint32_t operand = 0, double constant = 0) {
+            target.code.push_back({op, operand, constant});
+            depth = static_cast<std::size_t>(static_cast<long>(depth) + stackEffect);
+            maxDepth = std::max(maxDepth, depth);
+            return target.code.size() - 1;
+        }
+
+        void patch(std::size_t jump) {
+            target.code[jump].operand = static_cast<std::uint32_t>(target.code.size());
+        }
+
+        void ternary() {
+            Nested nested(*this);
+            logicalOr();
+            if (accept("?")) {
+                std::size_t toElse = emit(Op::JumpIfFalse, -1);
+                ternary();
+                expect(":");
+                std::size_t toEnd = emit(Op::Jump, -1);
+                patch(toElse);
+                ternary();
+                patch(toEnd);
+            }
+        }
+
+        // a || b: si a es verdadero se deja 1 en la pila sin evaluar b
+        void logicalOr() {
+            logicalAnd();
+            while (accept("||")) {
+                emit(Op::ToBoolean, 0);
+                std::size_t toEnd = emit(Op::JumpIfTrueOrPop, -1);
+                logicalAnd();
+                emit(Op::ToBoolean, 0);
+                patch(toEnd);
+            }
+        }
+
+        void logicalAnd() {
+            equality();
+            while (accept("&&")) {
+                emit(Op::ToBoolean, 0);
+                std::size_t toEnd = emit(Op::JumpIfFalseOrPop, -1);
+                equality();
+                emit(Op::ToBoolean, 0);
+                patch(toEnd);
+            }
+        }
+
+        void equality() {
+            relational();
+            for (;;) {
+                if (accept("==")) { relational(); emit(Op::Equal, -1); }
+                else if (accept("!=")) { relational(); emit(Op::NotEqual, -1); }
+                else return;
+            }
+        }
+
+        void relational() {
+            additive();
+            for (;;) {
+                if (accept("<=")) { additive(); emit(Op::LessEqual, -1); }
+                else if (accept(">=")) { additive(); emit(Op::GreaterEqual, -1); }
+                else if (accept("<")) { additive(); emit(Op::Less, -1); }
+                else if (accept(">")) { additive(); emit(Op::Greater, -1); }
+                else return;
+            }
+        }
+
+        void additive() {
+            multiplicative();
+            for (;;) {
+                if (accept("+")) { multiplicative(); emit(Op::Add, -1); }
+                else if (accept("-")) { multiplicative(); emit(Op::Subtract, -1); }
+                else return;
+            }
+        }
+
+        void multiplicative() {
+            unary();
+            for (;;) {
+                if (accept("*")) { unary(); emit(Op::Multiply, -1); }
+                else if (accept("/")) { unary(); emit(Op::Divide, -1); }
+                else if (accept("%")) { unary(); emit(Op::Modulo, -1); }
+                else return;
+            }
+        }
+
+        void unary() {
+            Nested nested(*this);
+            if (accept("-")) { unary(); emit(Op::Negate, 0); }
+            else if (accept("!")) { unary(); emit(Op::Not, 0); }
+            else primary();
+        }
+
+        void primary() {
+            skipSpaces();
+            if (accept("(")) {
+                ternary();
+                expect(")");
+                return;
+            }
+            if (position < source.size()
+                    && (std::isdigit(static_cast<unsigned char>(source[position])) || source[position] == '.')) {
+                // from_chars no depende del locale y no lee más allá del final de la vista
+                const char* begin = source.data() + position;
+                double value = 0;
+                auto result = std::from_chars(begin, source.data() + source.size(), value);
+                if (result.ec != std::errc()) {
+                    fail("Invalid number");
+                }
+                position += static_cast<std::size_t>(result.ptr - begin);
+                emit(Op::Constant, 1, 0, value);
+                return;
+            }
+            std::size_t start = position;
+            while (position < source.size()
+                    && (std::isalnum(static_cast<unsigned char>(source[position])) || source[position] == '_')) {
+                ++position;
+            }
+            if (start == position) {
+                fail("Unexpected token");
+            }
+            identifier(source.substr(start, position - start));
+        }
+
+        void identifier(std::string_view name) {
+            static constexpr std::pair<std::string_view, Field> FIELDS[] = {
+                {"latitude", Latitude}, {"longitude", Longitude}, {"altitude", Altitude},
+                {"speed", Speed}, {"course", Course}, {"valid", Valid},
+            };
+            if (name == "true" || name == "false") {
+                emit(Op::Constant, 1, 0, name == "true" ? 1 : 0);
+                return;
+            }
+            for (const auto& [fieldName, field] : FIELDS) {
+                if (name == fieldName) {
+                    emit(Op::Field, 1, field);
+                    return;
+                }
+            }
+            auto& names = target.attributeNames;
+            auto it = std::find(names.begin(), names.end(), name);
+            if (it == names.end()) {
+                it = names.insert(names.end(), std::string(name));
+            }
+            emit(Op::Attribute, 1, static_cast<std::uint32_t>(it - names.begin()));
+        }
+
+    public:
+        Compiler(CompiledExpression& target, std::string_view source) : target(target), source(source) {}
+
+        void compile() {
+            ternary();
+            skipSpaces();
+            if (position != source.size()) {
+                fail("Unexpected token");
+            }
+            if (maxDepth > MAX_STACK) {
+                fail("Expression too deep");
+            }
+        }
+    };
+
+    static bool truthy(double value) {
+        return value != 0 && !std::isnan(value);
+    }
+
+    static double field(const Position& position, std::uint32_t field) {
+        switch (field) {
+            case Latitude: return position.latitude;
+            case Longitude: return position.longitude;
+            case Altitude: return position.altitude;
+            case Speed: return position.speed;
+            case Course: return position.course;
+            default: return position.valid ? 1 : 0;
+        }
+    }
+
+public:
+    explicit CompiledExpression(std::string_view source) {
+        Compiler(*this, source).compile();
+    }
+
+    double evaluate(const Position& position) const {
+        double stack[MAX_STACK];
+        std::size_t top = 0;
+        std::size_t pc = 0;
+        while (pc < code.size()) {
+            const Instruction& instruction = code[pc++];
+            switch (instruction.op) {
+                case Op::Constant: stack[top++] = instruction.constant; break;
+                case Op::Field: stack[top++] = field(position, instruction.operand); break;
+                case Op::Attribute: {
+                    const double* value = position.findAttribute(attributeNames[instruction.operand]);
+                    stack[top++] = value ? *value : std::numeric_limits<double>::quiet_NaN();
+                    break;
+                }
+                case Op::Add: --top; stack[top - 1] += stack[top]; break;
+                case Op::Subtract: --top; stack[top - 1] -= stack[top]; break;
+                case Op::Multiply: --top; stack[top - 1] *= stack[top]; break;
+                case Op::Divide: --top; stack[top - 1] /= stack[top]; break;
+                case Op::Modulo: --top; stack[top - 1] = std::fmod(stack[top - 1], stack[top]); break;
+                case Op::Negate: stack[top - 1] = -stack[top - 1]; break;
+                case Op::Not: stack[top - 1] = truthy(stack[top - 1]) ? 0 : 1; break;
+                case Op::Less: --top; stack[top - 1] = stack[top - 1] < stack[top]; break;
+                case Op::LessEqual: --top; stack[top - 1] = stack[top - 1] <= stack[top]; break;
+                case Op::Greater: --top; stack[top - 1] = stack[top - 1] > stack[top]; break;
+                case Op::GreaterEqual: --top; stack[top - 1] = stack[top - 1] >= stack[top]; break;
+                case Op::Equal: --top; stack[top - 1] = stack[top - 1] == stack[top]; break;
+                case Op::NotEqual: --top; stack[top - 1] = stack[top - 1] != stack[top]; break;
+                case Op::Jump: pc = instruction.operand; break;
+                case Op::JumpIfFalse: if (!truthy(stack[--top])) pc = instruction.operand; break;
+                // && y ||: si se salta, la condición queda como resultado; si no, se descarta
+                case Op::JumpIfFalseOrPop:
+                    if (!truthy(stack[top - 1])) pc = instruction.operand; else --top;
+                    break;
+                case Op::JumpIfTrueOrPop:
+                    if (truthy(stack[top - 1])) pc = instruction.operand; else --top;
+                    break;
+                case Op::ToBoolean: stack[top - 1] = truthy(stack[top - 1]) ? 1 : 0; break;
+            }
+        }
+        return stack[0];
+    }
+};
+
+// Formas compiladas por ID de atributo; se sustituyen al añadir o actualizar el atributo y se
+// descartan al eliminarlo
+class ExpressionCache {
+private:
+    std::shared_mutex mutex;
+    std::unordered_map<long, std::shared_ptr<const CompiledExpression>> compiled;
+    // Cambia con cada invalidación; una compilación que empezó antes no se guarda
+    std::uint64_t generation = 0;
+
+public:
+    // "source" devuelve el texto de la expresión, o nullopt si el atributo no existe (y entonces
+    // get devuelve nullptr)
+    template <typename Source>
+    std::shared_ptr<const CompiledExpression> get(long id, Source source) {
+        std::uint64_t observed;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = compiled.find(id);
+            if (it != compiled.end()) {
+                return it->second;
+            }
+            observed = generation;
+        }
+        std::optional<std::string> text = source();
+        if (!text) {
+            return nullptr;
+        }
+        auto expression = std::make_shared<const CompiledExpression>(*text);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (generation != observed) {
+            return expression;
+        }
+        return compiled.try_emplace(id, std::move(expression)).first->second;
+    }
+
+    void put(long id, std::shared_ptr<const CompiledExpression> expression) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        compiled.insert_or_assign(id, std::move(expression));
+        ++generation;
+    }
+
+    void invalidate(long id) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        compiled.erase(id);
+        ++generation;
     }
 };
 
@@ -62,19 +506,45 @@ class AttributeResource {
 private:
     Logger logger;
     PermissionsService permissionsService;
-    Storage storage;
+    Storage<Attribute> storage;
+    ExpressionCache expressionCache;
     long userId;
 
+    // Atributos cuyo fallo de evaluación ya se registró; se olvidan al modificar el atributo
+    std::mutex failureMutex;
+    std::unordered_set<long> reportedFailures;
+
+    // Un atributo roto falla en cada posición: solo se registra la primera vez
+    void reportFailure(long id, const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!reportedFailures.insert(id).second) {
+                return;
+            }
+        }
+        logger.error("Error computing attribute " + std::to_string(id) + ": " + message);
+    }
+
+    void clearFailure(long id) {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        reportedFailures.erase(id);
+    }
+
 public:
     AttributeResource(long userId) : userId(userId) {
         logger.info("AttributeResource initialized for user: " + std::to_string(userId));
     }
 
-    void addAttribute(long id, const std::map<std::string, std::string>& attributes) {
+    // La expresión se compila antes de guardar: una expresión inválida se rechaza aquí y no en
+    // cada evaluación
+    void addAttribute(const Attribute& attribute) {
         try {
-            permissionsService.checkPermission(userId, "attribute", id);
-            storage.add(id, attributes);
-            logger.info("Attribute added with ID: " + std::to_string(id));
+            permissionsService.checkPermission(userId, "attribute", attribute.id);
+            auto expression = std::make_shared<const CompiledExpression>(attribute.expression);
+            storage.add(attribute);
+            expressionCache.put(attribute.id, std::move(expression));
+            clearFailure(attribute.id);
+            logger.info("Attribute added with ID: " + std::to_string(attribute.id));
         } catch (const std::exception& e) {
             logger.error("Error adding attribute: " + std::string(e.what()));
         }
@@ -83,30 +553,61 @@ public:
     void getAttribute(long id) {
         try {
             permissionsService.checkPermission(userId, "attribute", id);
-            auto attributes = storage.get(id);
+            Attribute attribute = storage.get(id);
             logger.info("Attributes fetched for ID: " + std::to_string(id));
-            for (const auto& [key, value] : attributes) {
-                std::cout << key << ": " << value << std::endl;
-            }
+            std::cout << "description: " << attribute.description << std::endl;
+            std::cout << "attribute: " << attribute.attribute << std::endl;
+            std::cout << "expression: " << attribute.expression << std::endl;
         } catch (const std::exception& e) {
             logger.error("Error fetching attribute: " + std::string(e.what()));
         }
     }
 
-    void updateAttribute(long id, const std::map<std::string, std::string>& attributes) {
+    void updateAttribute(const Attribute& attribute) {
         try {
-            permissionsService.checkPermission(userId, "attribute", id);
-            storage.update(id, attributes);
-            logger.info("Attribute updated for ID: " + std::to_string(id));
+            permissionsService.checkPermission(userId, "attribute", attribute.id);
+            auto expression = std::make_shared<const CompiledExpression>(attribute.expression);
+            storage.update(attribute);
+            expressionCache.put(attribute.id, std::move(expression));
+            clearFailure(attribute.id);
+            logger.info("Attribute updated for ID: " + std::to_string(attribute.id));
         } catch (const std::exception& e) {
             logger.error("Error updating attribute: " + std::string(e.what()));
         }
     }
 
+    // Camino caliente: evalúa el atributo calculado contra cada posición entrante. La expresión ya
+    // se compiló al guardarla, así que normalmente solo se ejecuta el bytecode. Sin excepciones por
+    // posición: nullopt si el atributo no existe o el resultado es NaN (p. ej. falta un atributo de
+    // la posición), y los fallos se registran una vez por atributo.
+    std::optional<double> computeAttribute(long id, const Position& position) {
+        std::shared_ptr<const CompiledExpression> expression;
+        try {
+            expression = expressionCache.get(id, [this, id]() -> std::optional<std::string> {
+                auto attribute = storage.tryGet(id);
+                return attribute ? std::optional<std::string>(std::move(attribute->expression)) : std::nullopt;
+            });
+        } catch (const std::exception& e) {
+            reportFailure(id, e.what());
+            return std::nullopt;
+        }
+        if (!expression) {
+            reportFailure(id, "Resource not found with ID: " + std::to_string(id));
+            return std::nullopt;
+        }
+        double value = expression->evaluate(position);
+        if (std::isnan(value)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
     void removeAttribute(long id) {
         try {
             permissionsService.checkPermission(userId, "attribute", id);
             storage.remove(id);
+            expressionCache.invalidate(id);
+            clearFailure(id);
             logger.info("Attribute removed with ID: " + std::to_string(id));
         } catch (const std::exception& e) {
             logger.error("Error removing attribute: " + std::string(e.what()));
@@ -118,10 +619,28 @@ int main() {
     AttributeResource resource(12345);
 
     // Simula operaciones CRUD sobre atributos
-    resource.addAttribute(1, {{"key1", "value1"}, {"key2", "value2"}});
+    resource.addAttribute({1, AttributeType::Number, "Speed in km/h", "speedKmh", "speed * 1.852"});
     resource.getAttribute(1);
-    resource.updateAttribute(1, {{"key1", "newValue1"}});
+
+    Position position;
+    position.speed = 70;
+    position.valid = true;
+    position.attributes = {{"ignition", 1}, {"fuel", 42.5}};
+    std::cout << "speedKmh: " << resource.computeAttribute(1, position).value_or(0) << std::endl;
+
+    // Al actualizar se sustituye la forma compilada anterior
+    resource.updateAttribute({1, AttributeType::Boolean, "Overspeed", "overspeed", "valid && ignition ? speed > 60 : fuel < 10"});
+    std::cout << "overspeed: " << resource.computeAttribute(1, position).value_or(0) << std::endl;
+
+    // Una expresión inválida se rechaza al guardarla y se conserva la anterior
+    resource.updateAttribute({1, AttributeType::Boolean, "Broken", "broken", "speed >"});
+    std::cout << "overspeed: " << resource.computeAttribute(1, position).value_or(0) << std::endl;
     resource.removeAttribute(1);
 
+    // Un atributo inexistente no lanza por posición y el fallo se registra una sola vez
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "removed: " << resource.computeAttribute(1, position).has_value() << std::endl;
+    }
+
     return 0;
 }
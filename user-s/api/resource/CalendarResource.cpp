@@ -3,6 +3,7 @@
 #include <map>
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
 
 class Logger {
 public:
@@ -15,62 +16,95 @@ public:
     }
 };
 
+// Calendario con campos tipados; "data" guarda el iCalendar original
+struct Calendar {
+    long id;
+    std::string name;
+    std::string description;
+    std::string data;
+};
+
+// Almacenamiento plano: registros contiguos ordenados por ID, búsqueda binaria y sin nodos por campo.
+// get() y getAll() devuelven copias, así que nada de lo que sale queda ligado a modificaciones posteriores.
+template <typename T>
 class Storage {
 private:
-    std::map<long, std::map<std::string, std::string>> database;
+    std::vector<T> records;
 
-public:
-    void add(long id, const std::map<std::string, std::string>& calendar) {
-        database[id] = calendar;
+    typename std::vector<T>::iterator find(long id) {
+        return std::lower_bound(records.begin(), records.end(), id,
+                [](const T& record, long key) { return record.id < key; });
+    }
+
+    typename std::vector<T>::const_iterator find(long id) const {
+        return std::lower_bound(records.begin(), records.end(), id,
+                [](const T& record, long key) { return record.id < key; });
     }
 
-    std::map<std::string, std::string> get(long id) {
-        if (database.find(id) != database.end()) {
-            return database[id];
+public:
+    // Los IDs nuevos suelen ser crecientes: se añaden al final en O(1) amortizado; solo un ID
+    // intermedio paga la inserción con desplazamiento
+    void add(T record) {
+        if (records.empty() || records.back().id < record.id) {
+            records.push_back(std::move(record));
+            return;
+        }
+        auto it = find(record.id);
+        if (it != records.end() && it->id == record.id) {
+            *it = std::move(record);
         } else {
+            records.insert(it, std::move(record));
+        }
+    }
+
+    T get(long id) const {
+        auto it = find(id);
+        if (it == records.end() || it->id != id) {
             throw std::runtime_error("Calendar not found with ID: " + std::to_string(id));
         }
+        return *it;
     }
 
-    void update(long id, const std::map<std::string, std::string>& calendar) {
-        if (database.find(id) != database.end()) {
-            database[id] = calendar;
-        } else {
-            throw std::runtime_error("Cannot update non-existing calendar with ID: " + std::to_string(id));
+    void update(T record) {
+        auto it = find(record.id);
+        if (it == records.end() || it->id != record.id) {
+            throw std::runtime_error("Cannot update non-existing calendar with ID: " + std::to_string(record.id));
         }
+        *it = std::move(record);
     }
 
     void remove(long id) {
-        if (database.find(id) != database.end()) {
-            database.erase(id);
-        } else {
+        auto it = find(id);
+        if (it == records.end() || it->id != id) {
             throw std::runtime_error("Cannot remove non-existing calendar with ID: " + std::to_string(id));
         }
+        records.erase(it);
     }
 
-    std::vector<std::map<std::string, std::string>> getAll() {
-        std::vector<std::map<std::string, std::string>> result;
-        for (const auto& entry : database) {
-            result.push_back(entry.second);
-        }
-        return result;
+    std::vector<T> getAll() const {
+        return records;
     }
 };
 
 class CalendarResource {
 private:
     Logger logger;
-    Storage storage;
+    Storage<Calendar> storage;
+
+    static void print(const Calendar& calendar) {
+        std::cout << "name: " << calendar.name << std::endl;
+        std::cout << "description: " << calendar.description << std::endl;
+    }
 
 public:
     CalendarResource() {
         logger.info("CalendarResource initialized.");
     }
 
-    void addCalendar(long id, const std::map<std::string, std::string>& calendar) {
+    void addCalendar(const Calendar& calendar) {
         try {
-            storage.add(id, calendar);
-            logger.info("Calendar added with ID: " + std::to_string(id));
+            storage.add(calendar);
+            logger.info("Calendar added with ID: " + std::to_string(calendar.id));
         } catch (const std::exception& e) {
             logger.error("Error adding calendar: " + std::string(e.what()));
         }
@@ -78,20 +112,18 @@ public:
 
     void getCalendar(long id) {
         try {
-            auto calendar = storage.get(id);
+            Calendar calendar = storage.get(id);
             logger.info("Calendar fetched for ID: " + std::to_string(id));
-            for (const auto& [key, value] : calendar) {
-                std::cout << key << ": " << value << std::endl;
-            }
+            print(calendar);
         } catch (const std::exception& e) {
             logger.error("Error fetching calendar: " + std::string(e.what()));
         }
     }
 
-    void updateCalendar(long id, const std::map<std::string, std::string>& calendar) {
+    void updateCalendar(const Calendar& calendar) {
         try {
-            storage.update(id, calendar);
-            logger.info("Calendar updated for ID: " + std::to_string(id));
+            storage.update(calendar);
+            logger.info("Calendar updated for ID: " + std::to_string(calendar.id));
         } catch (const std::exception& e) {
             logger.error("Error updating calendar: " + std::string(e.what()));
         }
@@ -111,9 +143,7 @@ public:
             auto calendars = storage.getAll();
             logger.info("Listing all calendars.");
             for (const auto& calendar : calendars) {
-                for (const auto& [key, value] : calendar) {
-                    std::cout << key << ": " << value << std::endl;
-                }
+                print(calendar);
                 std::cout << "-------------------" << std::endl;
             }
         } catch (const std::exception& e) {
@@ -126,9 +156,9 @@ int main() {
     CalendarResource resource;
 
     // Simula operaciones CRUD sobre calendarios
-    resource.addCalendar(1, {{"name", "Work Calendar"}, {"description", "Events for work."}});
+    resource.addCalendar({1, "Work Calendar", "Events for work.", ""});
     resource.getCalendar(1);
-    resource.updateCalendar(1, {{"name", "Updated Work Calendar"}});
+    resource.updateCalendar({1, "Updated Work Calendar", "", ""});
     resource.listCalendars();
     resource.removeCalendar(1);
 
@@ -4,6 +4,9 @@
 #include <vector>
 #include <stdexcept>
 #include <algorithm>
+#include <memory_resource>
+#include <string_view>
+#include "../RequestArena.h"
 
 class Logger {
 public:
@@ -20,15 +23,29 @@ public:
     }
 };
 
+// Consciente del allocator: dentro de un contenedor pmr el tipo se reserva en la misma memoria
 class Command {
 public:
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
     long id;
     long deviceId;
-    std::string type;
+    std::pmr::string type;
     bool textChannel;
 
-    Command(long id, long deviceId, const std::string& type, bool textChannel)
-        : id(id), deviceId(deviceId), type(type), textChannel(textChannel) {}
+    Command(long id, long deviceId, std::string_view type, bool textChannel, const allocator_type& allocator = {})
+        : id(id), deviceId(deviceId), type(type, allocator), textChannel(textChannel) {}
+
+    Command(const Command& other, const allocator_type& allocator)
+        : id(other.id), deviceId(other.deviceId), type(other.type, allocator), textChannel(other.textChannel) {}
+
+    Command(Command&& other, const allocator_type& allocator)
+        : id(other.id), deviceId(other.deviceId), type(std::move(other.type), allocator), textChannel(other.textChannel) {}
+
+    Command(const Command&) = default;
+    Command(Command&&) = default;
+    Command& operator=(const Command&) = default;
+    Command& operator=(Command&&) = default;
 };
 
 class PermissionsService {
@@ -40,6 +57,9 @@ public:
     }
 };
 
+// Comandos de una petición, reservados en su arena
+using CommandList = std::pmr::vector<Command>;
+
 class CommandsManager {
 public:
     Command sendCommand(const Command& command) {
@@ -60,21 +80,22 @@ public:
         logger.info("CommandResource initialized for user: " + std::to_string(userId));
     }
 
-    std::vector<Command> getCommands(long deviceId) {
+    // "memory" es la arena de la petición; el resultado vive mientras ella
+    CommandList getCommands(long deviceId, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
         try {
             permissionsService.checkPermission(userId, "device", deviceId);
 
             // Simulación de comandos obtenidos
-            std::vector<Command> commands = {
-                Command(1, deviceId, "TYPE_CUSTOM", true),
-                Command(2, deviceId, "TYPE_DATA", false)
-            };
+            CommandList commands(memory);
+            commands.reserve(2);
+            commands.emplace_back(1, deviceId, "TYPE_CUSTOM", true);
+            commands.emplace_back(2, deviceId, "TYPE_DATA", false);
 
             logger.info("Commands fetched for device ID: " + std::to_string(deviceId));
             return commands;
         } catch (const std::exception& e) {
             logger.error("Error fetching commands: " + std::string(e.what()));
-            return {};
+            return CommandList(memory);
         }
     }
 
@@ -90,25 +111,24 @@ public:
         }
     }
 
-    std::vector<std::string> getCommandTypes(bool textChannel) {
-        try {
-            std::vector<std::string> textCommands = {"TYPE_CUSTOM", "TYPE_TEXT"};
-            std::vector<std::string> dataCommands = {"TYPE_DATA", "TYPE_BINARY"};
+    // Los tipos son literales estáticos: la lista solo guarda vistas sobre ellos
+    std::pmr::vector<std::string_view> getCommandTypes(bool textChannel,
+            std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+        static constexpr std::string_view TEXT_COMMANDS[] = {"TYPE_CUSTOM", "TYPE_TEXT"};
+        static constexpr std::string_view DATA_COMMANDS[] = {"TYPE_DATA", "TYPE_BINARY"};
 
-            logger.info("Fetching command types for " + std::string(textChannel ? "text" : "data") + " channel.");
-            return textChannel ? textCommands : dataCommands;
-        } catch (const std::exception& e) {
-            logger.error("Error fetching command types: " + std::string(e.what()));
-            return {};
-        }
+        logger.info("Fetching command types for " + std::string(textChannel ? "text" : "data") + " channel.");
+        const auto& types = textChannel ? TEXT_COMMANDS : DATA_COMMANDS;
+        return std::pmr::vector<std::string_view>(std::begin(types), std::end(types), memory);
     }
 };
 
 int main() {
     CommandResource resource(12345);
 
-    // Obtener comandos
-    auto commands = resource.getCommands(1);
+    // Obtener comandos; cada petición usa su propia arena
+    RequestArena arena;
+    auto commands = resource.getCommands(1, arena.get());
     for (const auto& command : commands) {
         std::cout << "Command: " << command.type << " (Device ID: " << command.deviceId << ")" << std::endl;
     }
@@ -118,7 +138,8 @@ int main() {
     resource.sendCommand(commandToSend);
 
     // Obtener tipos de comandos
-    auto commandTypes = resource.getCommandTypes(true);
+    RequestArena typesArena;
+    auto commandTypes = resource.getCommandTypes(true, typesArena.get());
     for (const auto& type : commandTypes) {
         std::cout << "Command Type: " << type << std::endl;
     }
@@ -7,6 +7,18 @@
 #include <memory>
 #include <ctime>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <algorithm>
+#include <functional>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/asio.hpp>
+
+namespace net = boost::asio;
 
 class Logger {
 public:
@@ -42,15 +54,69 @@ public:
     }
 };
 
-class MediaManager {
+// Fichero temporal de subida; se borra al salir de ámbito salvo que se haya renombrado a su destino
+class TempFile {
+private:
+    std::string path;
+    int fd = -1;
+    bool committed = false;
+
 public:
-    std::ofstream createFileStream(const std::string& uniqueId, const std::string& name, const std::string& extension) {
-        std::string filePath = uniqueId + "_" + name + "." + extension;
-        std::ofstream file(filePath, std::ios::binary);
-        if (!file.is_open()) {
-            throw std::runtime_error("Failed to open file: " + filePath);
+    explicit TempFile(const std::string& prefix) : path(prefix + ".upload-XXXXXX") {
+        fd = ::mkstemp(path.data());
+        if (fd < 0) {
+            throw std::runtime_error("Failed to create temporary file: " + path);
+        }
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    ~TempFile() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        if (!committed) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    void write(const char* data, size_t length) {
+        while (length > 0) {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to write file: " + path);
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+        }
+    }
+
+    // Cierra el fichero y lo mueve atómicamente a su ruta final. mkstemp crea el temporal con 0600;
+    // se le dan los permisos habituales de un fichero de medios para que el servidor web pueda leerlo.
+    void commit(const std::string& target) {
+        int result = ::fchmod(fd, 0644);
+        result |= ::close(fd);
+        fd = -1;
+        if (result != 0 || ::rename(path.c_str(), target.c_str()) != 0) {
+            throw std::runtime_error("Failed to store file: " + target);
         }
-        return file;
+        committed = true;
+    }
+};
+
+class MediaManager {
+public:
+    std::string filePath(const std::string& uniqueId, const std::string& name, const std::string& extension) {
+        return uniqueId + "_" + name + "." + extension;
+    }
+
+    // El temporal se crea junto al destino para que el rename sea atómico
+    std::unique_ptr<TempFile> createTempFile(const std::string& uniqueId, const std::string& name) {
+        return std::make_unique<TempFile>(uniqueId + "_" + name);
     }
 };
 
@@ -61,6 +127,9 @@ private:
     MediaManager mediaManager;
 
     const long IMAGE_SIZE_LIMIT = 500000;
+    static constexpr size_t UPLOAD_BUFFER_SIZE = 256 * 1024;
+    // Bytes iniciales que se acumulan antes de detectar el tipo; dan margen al prólogo de un SVG
+    static constexpr size_t DETECT_BYTES = 1024;
 
     std::string imageExtension(const std::string& type) {
         if (type == "image/jpeg") return "jpg";
@@ -71,37 +140,184 @@ private:
         throw std::invalid_argument("Unsupported image type");
     }
 
+    // Detecta el tipo por los primeros bytes del contenido en lugar de fiarse del declarado
+    static std::optional<std::string> detectImageType(std::string_view head) {
+        auto startsWith = [&head](std::string_view prefix) {
+            return head.substr(0, prefix.size()) == prefix;
+        };
+        if (startsWith("\xFF\xD8\xFF")) return "image/jpeg";
+        if (startsWith("\x89PNG\r\n\x1A\n")) return "image/png";
+        if (startsWith("GIF87a") || startsWith("GIF89a")) return "image/gif";
+        if (startsWith("RIFF") && head.size() >= 12 && head.substr(8, 4) == "WEBP") return "image/webp";
+        if (isSvg(head)) return "image/svg+xml";
+        return std::nullopt;
+    }
+
+    // Un SVG debe tener <svg> como elemento raíz; antes solo se admiten la declaración XML,
+    // comentarios y DOCTYPE. Un XML cualquiera no basta.
+    static bool isSvg(std::string_view text) {
+        while (true) {
+            text.remove_prefix(std::min(text.find_first_not_of(" \t\r\n"), text.size()));
+            std::string_view terminator;
+            if (text.substr(0, 5) == "<?xml") {
+                terminator = "?>";
+            } else if (text.substr(0, 4) == "<!--") {
+                terminator = "-->";
+            } else if (text.substr(0, 9) == "<!DOCTYPE") {
+                terminator = ">";
+            } else {
+                break;
+            }
+            auto end = text.find(terminator);
+            if (end == std::string_view::npos) {
+                return false;
+            }
+            text.remove_prefix(end + terminator.size());
+        }
+        return text.size() > 4 && text.substr(0, 4) == "<svg"
+                && std::string_view(" \t\r\n>/").find(text[4]) != std::string_view::npos;
+    }
+
+    // Subida en curso: escribe cada bloque recibido en el temporal y detecta el tipo en cuanto hay
+    // DETECT_BYTES o todo el contenido, porque cada lectura puede devolver solo unos bytes
+    struct Upload {
+        long deviceId;
+        long contentLength;
+        std::string type;
+        std::unique_ptr<TempFile> tempFile;
+        std::unique_ptr<char[]> buffer{new char[UPLOAD_BUFFER_SIZE]};
+        std::string head;
+        std::optional<std::string> detectedType;
+        long transferred = 0;
+
+        size_t wanted() const {
+            return static_cast<size_t>(std::min<long>(contentLength - transferred, UPLOAD_BUFFER_SIZE));
+        }
+    };
+
+    // El tamaño se comprueba antes de leer nada
+    std::shared_ptr<Upload> beginUpload(long deviceId, long contentLength, const std::string& type) {
+        permissionsService.checkPermission(12345, "device", deviceId);
+        if (contentLength < 0) {
+            throw std::invalid_argument("Content-Length required");
+        }
+        if (contentLength > IMAGE_SIZE_LIMIT) {
+            throw std::invalid_argument("Image size limit exceeded");
+        }
+        auto upload = std::make_shared<Upload>();
+        upload->deviceId = deviceId;
+        upload->contentLength = contentLength;
+        upload->type = type;
+        upload->tempFile = mediaManager.createTempFile(std::to_string(deviceId), "device");
+        return upload;
+    }
+
+    static void consume(Upload& upload, size_t received) {
+        upload.tempFile->write(upload.buffer.get(), received);
+        upload.transferred += static_cast<long>(received);
+        if (!upload.detectedType) {
+            upload.head.append(upload.buffer.get(), std::min(received, DETECT_BYTES - upload.head.size()));
+            if (upload.head.size() == DETECT_BYTES || upload.transferred == upload.contentLength) {
+                upload.detectedType = detectImageType(upload.head);
+                if (!upload.detectedType) {
+                    throw std::invalid_argument("Unsupported image type");
+                }
+            }
+        }
+    }
+
+    // El temporal solo se renombra a su destino si la subida se completa
+    void finishUpload(Upload& upload) {
+        if (!upload.detectedType) {
+            throw std::invalid_argument("Empty image");
+        }
+        if (*upload.detectedType != upload.type) {
+            logger.warn("Declared type " + upload.type + " does not match content, using " + *upload.detectedType);
+        }
+        std::string uniqueId = std::to_string(upload.deviceId);
+        upload.tempFile->commit(mediaManager.filePath(uniqueId, "device", imageExtension(*upload.detectedType)));
+        logger.info("Image uploaded successfully for device ID: " + uniqueId);
+    }
+
+    void readBody(std::shared_ptr<net::ip::tcp::socket> socket, std::shared_ptr<Upload> upload,
+                  std::function<void(bool)> done) {
+        if (upload->transferred == upload->contentLength) {
+            bool stored = false;
+            try {
+                finishUpload(*upload);
+                stored = true;
+            } catch (const std::exception& e) {
+                logger.error("Error uploading image: " + std::string(e.what()));
+            }
+            done(stored);
+            return;
+        }
+        auto& stream = *socket;
+        stream.async_read_some(net::buffer(upload->buffer.get(), upload->wanted()),
+                [this, socket = std::move(socket), upload, done = std::move(done)](
+                        const boost::system::error_code& ec, size_t received) mutable {
+            try {
+                if (ec) {
+                    throw std::runtime_error("Incomplete upload: " + ec.message());
+                }
+                consume(*upload, received);
+            } catch (const std::exception& e) {
+                logger.error("Error uploading image: " + std::string(e.what()));
+                done(false);
+                return;
+            }
+            readBody(std::move(socket), std::move(upload), std::move(done));
+        });
+    }
+
 public:
     DeviceResource() {
         logger.info("DeviceResource initialized.");
     }
 
-    void uploadImage(long deviceId, const std::string& filePath, const std::string& type) {
+    // Sube una imagen leyendo exactamente contentLength bytes del cuerpo de la petición. Las lecturas
+    // son asíncronas: el hilo del io_context no se bloquea esperando al cliente y un socket en modo
+    // no bloqueante no se confunde con una subida incompleta. "done" recibe si se guardó la imagen.
+    void uploadImage(long deviceId, std::shared_ptr<net::ip::tcp::socket> socket, long contentLength,
+                     const std::string& type, std::function<void(bool)> done) {
+        std::shared_ptr<Upload> upload;
         try {
-            permissionsService.checkPermission(12345, "device", deviceId);
+            upload = beginUpload(deviceId, contentLength, type);
+        } catch (const std::exception& e) {
+            logger.error("Error uploading image: " + std::string(e.what()));
+            done(false);
+            return;
+        }
+        readBody(std::move(socket), std::move(upload), std::move(done));
+    }
 
-            std::string extension = imageExtension(type);
-            std::ifstream inputFile(filePath, std::ios::binary);
-            if (!inputFile.is_open()) {
-                throw std::runtime_error("Failed to open input file: " + filePath);
+    void uploadImage(long deviceId, const std::string& filePath, const std::string& type) {
+        int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info{};
+        if (fd < 0 || ::fstat(fd, &info) != 0) {
+            if (fd >= 0) {
+                ::close(fd);
             }
-
-            std::ofstream outputFile = mediaManager.createFileStream(std::to_string(deviceId), "device", extension);
-
-            char buffer[8192];
-            size_t transferred = 0;
-            while (inputFile.read(buffer, sizeof(buffer)) || inputFile.gcount() > 0) {
-                outputFile.write(buffer, inputFile.gcount());
-                transferred += inputFile.gcount();
-                if (transferred > IMAGE_SIZE_LIMIT) {
-                    throw std::invalid_argument("Image size limit exceeded");
+            logger.error("Error uploading image: Failed to open input file: " + filePath);
+            return;
+        }
+        try {
+            auto upload = beginUpload(deviceId, static_cast<long>(info.st_size), type);
+            while (upload->transferred < upload->contentLength) {
+                ssize_t received = ::read(fd, upload->buffer.get(), upload->wanted());
+                if (received < 0 && errno == EINTR) {
+                    continue;
                 }
+                if (received <= 0) {
+                    throw std::runtime_error("Incomplete upload");
+                }
+                consume(*upload, static_cast<size_t>(received));
             }
-
-            logger.info("Image uploaded successfully for device ID: " + std::to_string(deviceId));
+            finishUpload(*upload);
         } catch (const std::exception& e) {
             logger.error("Error uploading image: " + std::string(e.what()));
         }
+        ::close(fd);
     }
 };
 
@@ -111,5 +327,20 @@ int main() {
     // Simula la carga de una imagen para un dispositivo
     resource.uploadImage(1, "sample_image.jpg", "image/jpeg");
 
+    // Simula la subida del cuerpo de una petición por una conexión local
+    net::io_context ioc;
+    net::ip::tcp::acceptor acceptor(ioc, net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+    net::ip::tcp::socket client(ioc);
+    client.connect(acceptor.local_endpoint());
+    auto server = std::make_shared<net::ip::tcp::socket>(acceptor.accept());
+    server->non_blocking(true);
+
+    const std::string body = std::string("\x89PNG\r\n\x1A\n", 8) + std::string(2000, '\0');
+    resource.uploadImage(1, server, static_cast<long>(body.size()), "image/png", [](bool stored) {
+        std::cout << "Socket upload stored: " << std::boolalpha << stored << std::endl;
+    });
+    net::write(client, net::buffer(body));
+    ioc.run();
+
     return 0;
 }
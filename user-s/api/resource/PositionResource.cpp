@@ -5,6 +5,13 @@
 #include <stdexcept>
 #include <fstream>
 #include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <memory_resource>
+#include "../DateUtil.h"
+#include "../RequestArena.h"
 
 class Logger {
 public:
@@ -17,15 +24,19 @@ public:
     }
 };
 
+// La marca de tiempo se guarda en milisegundos; solo se convierte a texto al exportar o responder
 struct Position {
     long id;
     long deviceId;
-    std::string timestamp;
+    EpochMillis timestamp;
 
-    Position(long id, long deviceId, const std::string& timestamp)
+    Position(long id, long deviceId, EpochMillis timestamp)
         : id(id), deviceId(deviceId), timestamp(timestamp) {}
 };
 
+// Lista de posiciones de una petición, reservada en su arena
+using PositionList = std::pmr::vector<Position>;
+
 class PermissionsService {
 public:
     void checkPermission(long userId, long deviceId) {
@@ -43,14 +54,17 @@ public:
 
 class ExportProvider {
 public:
-    void generateCsv(const std::vector<Position>& positions, const std::string& filePath) {
+    void generateCsv(const PositionList& positions, const std::string& filePath) {
         std::ofstream file(filePath);
         if (!file.is_open()) {
             throw std::runtime_error("Failed to create CSV file: " + filePath);
         }
         file << "ID,DeviceID,Timestamp\n";
         for (const auto& position : positions) {
-            file << position.id << "," << position.deviceId << "," << position.timestamp << "\n";
+            char timestamp[DateUtil::ISO_LENGTH];
+            file << position.id << "," << position.deviceId << ",";
+            file.write(timestamp, static_cast<std::streamsize>(DateUtil::formatIso(position.timestamp, timestamp)));
+            file << "\n";
         }
         file.close();
     }
@@ -62,37 +76,71 @@ private:
     PermissionsService permissionsService;
     ExportProvider exportProvider;
 
+    // Ordenada por (deviceId, timestamp) para que los rangos de tiempo sean búsquedas binarias
     std::vector<Position> mockDatabase;
 
+    static bool positionLess(const Position& left, const Position& right) {
+        return left.deviceId != right.deviceId ? left.deviceId < right.deviceId : left.timestamp < right.timestamp;
+    }
+
+    void addPosition(long id, long deviceId, std::string_view timestamp) {
+        auto time = DateUtil::parseIso(timestamp);
+        if (!time) {
+            throw std::invalid_argument("Invalid timestamp: " + std::string(timestamp));
+        }
+        Position position(id, deviceId, *time);
+        mockDatabase.insert(std::upper_bound(mockDatabase.begin(), mockDatabase.end(), position, positionLess), position);
+    }
+
 public:
     PositionResource() {
         logger.info("PositionResource initialized.");
-        mockDatabase.push_back(Position(1, 1001, "2025-01-01T10:00:00Z"));
-        mockDatabase.push_back(Position(2, 1001, "2025-01-01T10:05:00Z"));
-        mockDatabase.push_back(Position(3, 1002, "2025-01-01T11:00:00Z"));
+        addPosition(1, 1001, "2025-01-01T10:00:00Z");
+        addPosition(2, 1001, "2025-01-01T10:05:00Z");
+        addPosition(3, 1002, "2025-01-01T11:00:00Z");
     }
 
-    std::vector<Position> getPositions(long deviceId) {
+    // "memory" es la arena de la petición; el resultado vive mientras ella
+    PositionList getPositions(long deviceId, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+        return getPositions(deviceId, std::nullopt, std::nullopt, memory);
+    }
+
+    // Posiciones del dispositivo en [from, to]; el filtro es una comparación de enteros
+    PositionList getPositions(long deviceId, std::optional<EpochMillis> from, std::optional<EpochMillis> to,
+                              std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
         try {
             permissionsService.checkPermission(12345, deviceId);
-            std::vector<Position> result;
-            for (const auto& position : mockDatabase) {
-                if (position.deviceId == deviceId) {
-                    result.push_back(position);
-                }
-            }
+            auto first = std::lower_bound(mockDatabase.begin(), mockDatabase.end(),
+                    Position(0, deviceId, from.value_or(INT64_MIN)), positionLess);
+            auto last = std::upper_bound(first, mockDatabase.end(),
+                    Position(0, deviceId, to.value_or(INT64_MAX)), positionLess);
+            PositionList result(first, last, memory);
             logger.info("Positions fetched for device ID: " + std::to_string(deviceId));
             return result;
         } catch (const std::exception& e) {
             logger.error("Error fetching positions: " + std::string(e.what()));
-            return {};
+            return PositionList(memory);
+        }
+    }
+
+    // Entrada desde la API: las fechas ISO-8601 se convierten una sola vez; un extremo vacío
+    // deja el rango abierto por ese lado
+    PositionList getPositions(long deviceId, std::string_view from, std::string_view to,
+                              std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+        auto fromTime = from.empty() ? std::nullopt : DateUtil::parseIso(from);
+        auto toTime = to.empty() ? std::nullopt : DateUtil::parseIso(to);
+        if ((!from.empty() && !fromTime) || (!to.empty() && !toTime)) {
+            logger.error("Error fetching positions: invalid time range");
+            return PositionList(memory);
         }
+        return getPositions(deviceId, fromTime, toTime, memory);
     }
 
     void exportPositionsToCsv(long deviceId, const std::string& filePath) {
         try {
             permissionsService.checkPermission(12345, deviceId);
-            auto positions = getPositions(deviceId);
+            RequestArena arena;
+            auto positions = getPositions(deviceId, arena.get());
             exportProvider.generateCsv(positions, filePath);
             logger.info("Positions exported to CSV for device ID: " + std::to_string(deviceId));
         } catch (const std::exception& e) {
@@ -104,12 +152,18 @@ public:
 int main() {
     PositionResource resource;
 
-    // Obtener posiciones
-    auto positions = resource.getPositions(1001);
+    // Obtener posiciones; cada petición usa su propia arena
+    RequestArena arena;
+    auto positions = resource.getPositions(1001, arena.get());
     for (const auto& position : positions) {
-        std::cout << "Position ID: " << position.id << ", Timestamp: " << position.timestamp << std::endl;
+        std::cout << "Position ID: " << position.id << ", Timestamp: " << DateUtil::formatIso(position.timestamp) << std::endl;
     }
 
+    // Rango de tiempo
+    RequestArena rangeArena;
+    auto range = resource.getPositions(1001, "2025-01-01T10:01:00Z", "2025-01-01T11:00:00Z", rangeArena.get());
+    std::cout << "Positions in range: " << range.size() << std::endl;
+
     // Exportar posiciones a CSV
     resource.exportPositionsToCsv(1001, "positions.csv");
 
@@ -4,6 +4,11 @@
 #include <fstream>
 #include <stdexcept>
 #include <map>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "../DateUtil.h"
 
 class Logger {
 public:
@@ -19,7 +24,7 @@ public:
 struct ReportItem {
     long id;
     std::string name;
-    std::string timestamp;
+    EpochMillis timestamp;
 };
 
 class PermissionsService {
@@ -40,7 +45,7 @@ public:
         }
         file << "ID,Name,Timestamp\n";
         for (const auto& item : items) {
-            file << item.id << "," << item.name << "," << item.timestamp << "\n";
+            file << item.id << "," << item.name << "," << DateUtil::formatIso(item.timestamp) << "\n";
         }
         file.close();
     }
@@ -57,21 +62,44 @@ private:
 public:
     ReportResource() {
         logger.info("ReportResource initialized.");
-        mockDatabase.push_back({1, "Item 1", "2025-01-01T10:00:00Z"});
-        mockDatabase.push_back({2, "Item 2", "2025-01-01T10:30:00Z"});
+        mockDatabase.push_back({1, "Item 1", *DateUtil::parseIso("2025-01-01T10:00:00Z")});
+        mockDatabase.push_back({2, "Item 2", *DateUtil::parseIso("2025-01-01T10:30:00Z")});
     }
 
     std::vector<ReportItem> getSummary(long userId) {
+        return getSummary(userId, std::nullopt, std::nullopt);
+    }
+
+    // Elementos con marca de tiempo en [from, to]; el filtro compara enteros
+    std::vector<ReportItem> getSummary(long userId, std::optional<EpochMillis> from, std::optional<EpochMillis> to) {
         try {
             permissionsService.checkRestriction(userId, "summary");
             logger.info("Fetching summary report.");
-            return mockDatabase;
+            EpochMillis lower = from.value_or(INT64_MIN);
+            EpochMillis upper = to.value_or(INT64_MAX);
+            std::vector<ReportItem> result;
+            std::copy_if(mockDatabase.begin(), mockDatabase.end(), std::back_inserter(result), [=](const ReportItem& item) {
+                return item.timestamp >= lower && item.timestamp <= upper;
+            });
+            return result;
         } catch (const std::exception& e) {
             logger.error("Error fetching summary report: " + std::string(e.what()));
             return {};
         }
     }
 
+    // Entrada desde la API: las fechas ISO-8601 se convierten una sola vez; un extremo vacío
+    // deja el rango abierto por ese lado
+    std::vector<ReportItem> getSummary(long userId, std::string_view from, std::string_view to) {
+        auto fromTime = from.empty() ? std::nullopt : DateUtil::parseIso(from);
+        auto toTime = to.empty() ? std::nullopt : DateUtil::parseIso(to);
+        if ((!from.empty() && !fromTime) || (!to.empty() && !toTime)) {
+            logger.error("Error fetching summary report: invalid time range");
+            return {};
+        }
+        return getSummary(userId, fromTime, toTime);
+    }
+
     void exportSummaryToCsv(long userId, const std::string& filePath) {
         try {
             permissionsService.checkRestriction(userId, "summary");
@@ -92,7 +120,7 @@ int main() {
     // Obtener resumen
     auto summary = resource.getSummary(userId);
     for (const auto& item : summary) {
-        std::cout << "ID: " << item.id << ", Name: " << item.name << ", Timestamp: " << item.timestamp << std::endl;
+        std::cout << "ID: " << item.id << ", Name: " << item.name << ", Timestamp: " << DateUtil::formatIso(item.timestamp) << std::endl;
     }
 
     // Exportar resumen a CSV
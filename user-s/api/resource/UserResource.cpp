@@ -4,6 +4,9 @@
 #include <map>
 #include <stdexcept>
 #include <memory>
+#include <algorithm>
+#include <memory_resource>
+#include "../RequestArena.h"
 
 class Logger {
 public:
@@ -16,6 +19,7 @@ public:
     }
 };
 
+// Modelo almacenado: vive más que cualquier petición, así que usa el allocator global
 class User {
 public:
     long id;
@@ -26,6 +30,34 @@ public:
         : id(id), name(name), administrator(administrator) {}
 };
 
+// Copia de un usuario para la respuesta de una petición. Consciente del allocator: dentro de un
+// contenedor pmr el nombre se reserva en la misma arena y se libera con ella.
+class UserView {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    long id;
+    std::pmr::string name;
+    bool administrator;
+
+    UserView(const User& user, const allocator_type& allocator = {})
+        : id(user.id), name(user.name, allocator), administrator(user.administrator) {}
+
+    UserView(const UserView& other, const allocator_type& allocator)
+        : id(other.id), name(other.name, allocator), administrator(other.administrator) {}
+
+    UserView(UserView&& other, const allocator_type& allocator)
+        : id(other.id), name(std::move(other.name), allocator), administrator(other.administrator) {}
+
+    UserView(const UserView&) = default;
+    UserView(UserView&&) = default;
+    UserView& operator=(const UserView&) = default;
+    UserView& operator=(UserView&&) = default;
+};
+
+// Usuarios de una petición, copiados en su arena
+using UserList = std::pmr::vector<UserView>;
+
 class PermissionsService {
 public:
     void checkUser(long requesterId, long targetId) {
@@ -50,7 +82,7 @@ public:
         database.emplace_back(2, "User1", false);
     }
 
-    std::vector<User> getUsers() {
+    const std::vector<User>& getUsers() const {
         return database;
     }
 
@@ -80,18 +112,25 @@ public:
         logger.info("UserResource initialized.");
     }
 
-    std::vector<User> getUsers(long requesterId) {
+    // Copia de la lista en la arena de la petición, nombres incluidos: no depende de que el
+    // almacenamiento siga sin cambios y se libera entera con la arena
+    UserList getUsers(long requesterId, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+        UserList users(memory);
         try {
             if (!permissionsService.isAdmin(requesterId)) {
                 throw std::runtime_error("Only administrators can access user list.");
             }
-            auto users = storage.getUsers();
+            const auto& stored = storage.getUsers();
+            users.reserve(stored.size());
+            for (const auto& user : stored) {
+                users.emplace_back(user);
+            }
             logger.info("User list fetched.");
-            return users;
         } catch (const std::exception& e) {
             logger.error("Error fetching users: " + std::string(e.what()));
-            return {};
+            users.clear();
         }
+        return users;
     }
 
     void addUser(long requesterId, const std::string& name, bool isAdmin) {
@@ -122,7 +161,8 @@ int main() {
 
     // Obtener lista de usuarios
     try {
-        auto users = resource.getUsers(1);
+        RequestArena arena;
+        auto users = resource.getUsers(1, arena.get());
         for (const auto& user : users) {
             std::cout << "ID: " << user.id << ", Name: " << user.name << ", Admin: " << user.administrator << std::endl;
         }
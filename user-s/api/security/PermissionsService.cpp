@@ -5,6 +5,7 @@
 #include <memory>
 #include <functional>
 #include <optional>
+#include "../ApiError.h"
 
 class Logger {
 public:
@@ -44,11 +45,12 @@ public:
         users[2] = std::make_shared<User>(2, "User", false, 2, 0);
     }
 
-    std::shared_ptr<User> getUser(long userId) {
-        if (users.find(userId) != users.end()) {
-            return users[userId];
+    Expected<std::shared_ptr<User>> getUser(long userId) const {
+        auto it = users.find(userId);
+        if (it == users.end()) {
+            return ApiError{ErrorCode::UserNotFound, userId};
         }
-        throw std::runtime_error("User not found with ID: " + std::to_string(userId));
+        return it->second;
     }
 };
 
@@ -62,50 +64,67 @@ public:
         logger.info("PermissionsService initialized.");
     }
 
-    bool notAdmin(long userId) {
+    // Las denegaciones se devuelven como ApiError: en cargas con muchos 403 lanzar excepciones
+    // dominaba el coste de la petición
+    Expected<bool> notAdmin(long userId) const {
         auto user = storage.getUser(userId);
-        return !user->isAdmin();
+        if (!user) {
+            return user.error();
+        }
+        return !(*user)->isAdmin();
     }
 
-    void checkAdmin(long userId) {
-        if (notAdmin(userId)) {
-            throw std::runtime_error("Administrator access required.");
+    Expected<void> checkAdmin(long userId) const {
+        auto result = notAdmin(userId);
+        if (!result) {
+            return result.error();
+        }
+        if (*result) {
+            return ApiError{ErrorCode::AdminRequired};
         }
+        return {};
     }
 
-    void checkUser(long userId, long targetUserId) {
-        if (userId != targetUserId && notAdmin(userId)) {
-            throw std::runtime_error("Access denied to user: " + std::to_string(targetUserId));
+    Expected<void> checkUser(long userId, long targetUserId) const {
+        if (userId == targetUserId) {
+            return {};
+        }
+        auto result = notAdmin(userId);
+        if (!result) {
+            return result.error();
         }
+        if (*result) {
+            return ApiError{ErrorCode::UserAccessDenied, targetUserId};
+        }
+        return {};
     }
 
     template <typename T>
-    void checkPermission(long userId, long objectId) {
-        if (notAdmin(userId)) {
-            throw std::runtime_error("Access denied to object with ID: " + std::to_string(objectId));
+    Expected<void> checkPermission(long userId, long objectId) const {
+        auto result = notAdmin(userId);
+        if (!result) {
+            return result.error();
+        }
+        if (*result) {
+            return ApiError{ErrorCode::Forbidden, objectId};
         }
+        return {};
     }
 };
 
 int main() {
     PermissionsService permissionsService;
 
-    try {
-        permissionsService.checkAdmin(2);
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+    if (auto result = permissionsService.checkAdmin(2); !result) {
+        std::cerr << result.error().message() << std::endl;
     }
 
-    try {
-        permissionsService.checkUser(2, 1);
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+    if (auto result = permissionsService.checkUser(2, 1); !result) {
+        std::cerr << result.error().message() << std::endl;
     }
 
-    try {
-        permissionsService.checkPermission<int>(2, 100);
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+    if (auto result = permissionsService.checkPermission<int>(2, 100); !result) {
+        std::cerr << result.error().message() << std::endl;
     }
 
     return 0;